@@ -0,0 +1,237 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavClusters.h"
+#include "SpiderNavigationModule.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavSearchContext.h"
+
+FSpiderNavClusters::FSpiderNavClusters()
+{
+	ClustersNum = 0;
+}
+
+void FSpiderNavClusters::Compute(const FSpiderNavGraph& NavGraph, float ClusterSize, TArray<int32>& OutClusterIds, TArray<FSpiderNavAbstractEdge>& OutAbstractEdges)
+{
+	const int32 NodesNum = NavGraph.Num();
+	const float InvClusterSize = 1.0f / FMath::Max(ClusterSize, KINDA_SMALL_NUMBER);
+
+	OutClusterIds.SetNumUninitialized(NodesNum);
+	OutAbstractEdges.Reset();
+
+	// assign each node to the cube of space which contains it
+	TMap<FIntVector, int32> ClustersByCoord;
+	for (int32 i = 0; i != NodesNum; ++i) {
+		const FVector Location = NavGraph.GetLocation(i);
+		FIntVector Coord(
+			FMath::FloorToInt(Location.X * InvClusterSize),
+			FMath::FloorToInt(Location.Y * InvClusterSize),
+			FMath::FloorToInt(Location.Z * InvClusterSize)
+		);
+		int32* ClusterId = ClustersByCoord.Find(Coord);
+		OutClusterIds[i] = ClusterId ? *ClusterId : ClustersByCoord.Add(Coord, ClustersByCoord.Num());
+	}
+	const int32 NewClustersNum = ClustersByCoord.Num();
+
+	// choose edges crossing borders between clusters, which are not too close to each other
+	struct FTransition
+	{
+		int32 From;
+		int32 To;
+		float Cost;
+		FVector Middle;
+	};
+	TMap<uint64, TArray<FTransition>> TransitionsByClusters;
+	const float MinTransitionsDistanceSquared = FMath::Square(ClusterSize * 0.5f);
+
+	for (int32 From = 0; From != NodesNum; ++From) {
+		const int32 FromCluster = OutClusterIds[From];
+		for (int32 Edge = NavGraph.GetEdgesBegin(From); Edge != NavGraph.GetEdgesEnd(From); ++Edge) {
+			const int32 To = NavGraph.EdgeTargets[Edge];
+			const int32 ToCluster = OutClusterIds[To];
+			// edges are symmetric, so take each of them once
+			if (FromCluster >= ToCluster) {
+				continue;
+			}
+
+			FVector Middle = (NavGraph.GetLocation(From) + NavGraph.GetLocation(To)) * 0.5f;
+			TArray<FTransition>& Transitions = TransitionsByClusters.FindOrAdd(((uint64)FromCluster << 32) | (uint32)ToCluster);
+			bool bIsTooClose = false;
+			for (const FTransition& Transition : Transitions) {
+				if (FVector::DistSquared(Transition.Middle, Middle) < MinTransitionsDistanceSquared) {
+					bIsTooClose = true;
+					break;
+				}
+			}
+			if (!bIsTooClose) {
+				Transitions.Add({ From, To, NavGraph.EdgeCosts[Edge], Middle });
+			}
+		}
+	}
+
+	// ends of chosen edges are entrances of clusters
+	TArray<TArray<int32>> EntrancesByCluster;
+	EntrancesByCluster.SetNum(NewClustersNum);
+	TArray<bool> IsEntrance;
+	IsEntrance.Init(false, NodesNum);
+	for (auto It = TransitionsByClusters.CreateConstIterator(); It; ++It) {
+		for (const FTransition& Transition : It.Value()) {
+			OutAbstractEdges.Add(FSpiderNavAbstractEdge(Transition.From, Transition.To, Transition.Cost));
+			OutAbstractEdges.Add(FSpiderNavAbstractEdge(Transition.To, Transition.From, Transition.Cost));
+			for (int32 Node : { Transition.From, Transition.To }) {
+				if (!IsEntrance[Node]) {
+					IsEntrance[Node] = true;
+					EntrancesByCluster[OutClusterIds[Node]].Add(Node);
+				}
+			}
+		}
+	}
+
+	// find paths between entrances of each cluster which do not leave the cluster
+	FSpiderNavSearchContext Context;
+	for (int32 Cluster = 0; Cluster != NewClustersNum; ++Cluster) {
+		const TArray<int32>& ClusterEntrances = EntrancesByCluster[Cluster];
+		if (ClusterEntrances.Num() < 2) {
+			continue;
+		}
+
+		for (int32 Entrance : ClusterEntrances) {
+			Context.Reset(NodesNum);
+			Context.GetNode(Entrance).bOpened = true;
+			Context.PushOpenNode(Entrance);
+
+			while (Context.HasOpenNodes()) {
+				int32 NodeIndex = Context.PopOpenNode();
+				FSpiderNavSearchNode& SearchNode = Context.GetNode(NodeIndex);
+				SearchNode.bClosed = true;
+
+				for (int32 Edge = NavGraph.GetEdgesBegin(NodeIndex); Edge != NavGraph.GetEdgesEnd(NodeIndex); ++Edge) {
+					const int32 NeighborIndex = NavGraph.EdgeTargets[Edge];
+					if (OutClusterIds[NeighborIndex] != Cluster) {
+						continue;
+					}
+					FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+					if (SearchNeighbor.bClosed) {
+						continue;
+					}
+					float NewG = SearchNode.G + NavGraph.EdgeCosts[Edge];
+					if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+						SearchNeighbor.G = NewG;
+						SearchNeighbor.F = NewG;
+						SearchNeighbor.ParentIndex = NodeIndex;
+						if (!SearchNeighbor.bOpened) {
+							SearchNeighbor.bOpened = true;
+							Context.PushOpenNode(NeighborIndex);
+						} else {
+							Context.DecreaseOpenNode(NeighborIndex);
+						}
+					}
+				}
+			}
+
+			for (int32 OtherEntrance : ClusterEntrances) {
+				const FSpiderNavSearchNode* SearchNode = Context.FindNode(OtherEntrance);
+				if (OtherEntrance != Entrance && SearchNode && SearchNode->bClosed) {
+					OutAbstractEdges.Add(FSpiderNavAbstractEdge(Entrance, OtherEntrance, SearchNode->G));
+				}
+			}
+		}
+	}
+}
+
+void FSpiderNavClusters::Build(TArray<int32>&& InClusterIds, const TArray<FSpiderNavAbstractEdge>& InAbstractEdges)
+{
+	Empty();
+	ClusterIds = MoveTemp(InClusterIds);
+	for (int32 ClusterId : ClusterIds) {
+		ClustersNum = FMath::Max(ClustersNum, ClusterId + 1);
+	}
+
+	// number abstract nodes in order of their appearance in edges
+	TMap<int32, int32> AbstractIndexes;
+	TArray<int32> EdgeSources;
+	TArray<int32> EdgeTargetNodes;
+	EdgeSources.Reserve(InAbstractEdges.Num());
+	EdgeTargetNodes.Reserve(InAbstractEdges.Num());
+	for (const FSpiderNavAbstractEdge& Edge : InAbstractEdges) {
+		if (!ClusterIds.IsValidIndex(Edge.From) || !ClusterIds.IsValidIndex(Edge.To)) {
+			continue;
+		}
+		for (int32 Node : { Edge.From, Edge.To }) {
+			if (!AbstractIndexes.Contains(Node)) {
+				AbstractIndexes.Add(Node, AbstractNodes.Add(Node));
+			}
+		}
+		EdgeSources.Add(AbstractIndexes[Edge.From]);
+		EdgeTargetNodes.Add(AbstractIndexes[Edge.To]);
+	}
+
+	const int32 AbstractNodesNum = AbstractNodes.Num();
+	EdgeOffsets.SetNumZeroed(AbstractNodesNum + 1);
+	for (int32 Source : EdgeSources) {
+		EdgeOffsets[Source + 1]++;
+	}
+	for (int32 i = 0; i != AbstractNodesNum; ++i) {
+		EdgeOffsets[i + 1] += EdgeOffsets[i];
+	}
+	TArray<int32> Cursors;
+	Cursors.Append(EdgeOffsets.GetData(), AbstractNodesNum);
+	EdgeTargets.SetNumUninitialized(EdgeSources.Num());
+	EdgeCosts.SetNumUninitialized(EdgeSources.Num());
+	int32 EdgeIndex = 0;
+	for (const FSpiderNavAbstractEdge& Edge : InAbstractEdges) {
+		if (!ClusterIds.IsValidIndex(Edge.From) || !ClusterIds.IsValidIndex(Edge.To)) {
+			continue;
+		}
+		const int32 Slot = Cursors[EdgeSources[EdgeIndex]]++;
+		EdgeTargets[Slot] = EdgeTargetNodes[EdgeIndex];
+		EdgeCosts[Slot] = Edge.Cost;
+		EdgeIndex++;
+	}
+
+	// group abstract nodes by clusters
+	EntrancesOffsets.SetNumZeroed(ClustersNum + 1);
+	for (int32 Node : AbstractNodes) {
+		EntrancesOffsets[ClusterIds[Node] + 1]++;
+	}
+	for (int32 i = 0; i != ClustersNum; ++i) {
+		EntrancesOffsets[i + 1] += EntrancesOffsets[i];
+	}
+	Cursors.Reset();
+	Cursors.Append(EntrancesOffsets.GetData(), ClustersNum);
+	Entrances.SetNumUninitialized(AbstractNodesNum);
+	for (int32 i = 0; i != AbstractNodesNum; ++i) {
+		Entrances[Cursors[ClusterIds[AbstractNodes[i]]]++] = i;
+	}
+}
+
+void FSpiderNavClusters::Empty()
+{
+	ClusterIds.Empty();
+	ClustersNum = 0;
+	AbstractNodes.Empty();
+	EntrancesOffsets.Empty();
+	Entrances.Empty();
+	EdgeOffsets.Empty();
+	EdgeTargets.Empty();
+	EdgeCosts.Empty();
+}
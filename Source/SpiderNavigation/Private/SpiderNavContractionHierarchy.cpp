@@ -0,0 +1,410 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavContractionHierarchy.h"
+#include "SpiderNavigationModule.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavSearchContext.h"
+#include "Algo/Reverse.h"
+
+namespace SpiderNavContraction
+{
+	/** Edge of graph which remains during contraction */
+	struct FEdge
+	{
+		int32 Target;
+		float Cost;
+		int32 Middle;
+	};
+
+	/** Entry of priority queues of contraction */
+	struct FQueueEntry
+	{
+		float Key;
+		int32 Node;
+
+		FORCEINLINE bool operator<(const FQueueEntry& Other) const
+		{
+			return Key < Other.Key;
+		}
+	};
+
+	/** Witness search stops after this number of settled nodes and shortcut is added then. It keeps preprocessing fast */
+	static const int32 MaxSettledNodesNum = 256;
+
+	/** Adds edge or decreases cost of existing one */
+	static void AddEdge(TArray<FEdge>& Edges, int32 Target, float Cost, int32 Middle)
+	{
+		for (FEdge& Edge : Edges) {
+			if (Edge.Target == Target) {
+				if (Cost < Edge.Cost) {
+					Edge.Cost = Cost;
+					Edge.Middle = Middle;
+				}
+				return;
+			}
+		}
+		Edges.Add({ Target, Cost, Middle });
+	}
+
+	/** Local Dijkstra which looks for paths between neighbors of contracted node avoiding it */
+	class FWitnessSearch
+	{
+	public:
+		void Reset(int32 NodesNum)
+		{
+			Distances.SetNumUninitialized(NodesNum);
+			Stamps.Init(0, NodesNum);
+			Stamp = 0;
+		}
+
+		void Run(const TArray<TArray<FEdge>>& Edges, const TArray<int32>& Ranks, int32 SourceIndex, int32 IgnoredIndex, float MaxCost)
+		{
+			Stamp++;
+			Queue.Reset();
+			SetDistance(SourceIndex, 0.0f);
+			Queue.HeapPush({ 0.0f, SourceIndex });
+
+			int32 SettledNodesNum = 0;
+			while (Queue.Num() && SettledNodesNum < MaxSettledNodesNum) {
+				FQueueEntry Entry;
+				Queue.HeapPop(Entry, false);
+				if (Entry.Key > GetDistance(Entry.Node)) {
+					continue;
+				}
+				if (Entry.Key > MaxCost) {
+					break;
+				}
+				SettledNodesNum++;
+
+				for (const FEdge& Edge : Edges[Entry.Node]) {
+					if (Edge.Target == IgnoredIndex || Ranks[Edge.Target] != INDEX_NONE) {
+						continue;
+					}
+					const float NewDistance = Entry.Key + Edge.Cost;
+					if (NewDistance < GetDistance(Edge.Target)) {
+						SetDistance(Edge.Target, NewDistance);
+						Queue.HeapPush({ NewDistance, Edge.Target });
+					}
+				}
+			}
+		}
+
+		FORCEINLINE float GetDistance(int32 Index) const
+		{
+			return Stamps[Index] == Stamp ? Distances[Index] : MAX_flt;
+		}
+
+	protected:
+		FORCEINLINE void SetDistance(int32 Index, float Distance)
+		{
+			Stamps[Index] = Stamp;
+			Distances[Index] = Distance;
+		}
+
+		TArray<float> Distances;
+		TArray<uint32> Stamps;
+		uint32 Stamp;
+		TArray<FQueueEntry> Queue;
+	};
+
+	/** Finds shortcuts needed to contract node. Adds them to OutShortcuts if passed. Returns number of shortcuts */
+	static int32 ContractNode(const TArray<TArray<FEdge>>& Edges, const TArray<int32>& Ranks, FWitnessSearch& WitnessSearch, int32 NodeIndex, TArray<FSpiderNavHierarchyEdge>* OutShortcuts)
+	{
+		TArray<FEdge, TInlineAllocator<32>> Neighbors;
+		for (const FEdge& Edge : Edges[NodeIndex]) {
+			if (Ranks[Edge.Target] == INDEX_NONE) {
+				Neighbors.Add(Edge);
+			}
+		}
+
+		int32 ShortcutsNum = 0;
+		for (int32 i = 0; i < Neighbors.Num(); i++) {
+			float MaxCost = 0.0f;
+			for (int32 j = i + 1; j < Neighbors.Num(); j++) {
+				MaxCost = FMath::Max(MaxCost, Neighbors[i].Cost + Neighbors[j].Cost);
+			}
+			if (MaxCost == 0.0f) {
+				continue;
+			}
+
+			WitnessSearch.Run(Edges, Ranks, Neighbors[i].Target, NodeIndex, MaxCost);
+			for (int32 j = i + 1; j < Neighbors.Num(); j++) {
+				const float Cost = Neighbors[i].Cost + Neighbors[j].Cost;
+				if (WitnessSearch.GetDistance(Neighbors[j].Target) > Cost) {
+					ShortcutsNum++;
+					if (OutShortcuts) {
+						OutShortcuts->Add(FSpiderNavHierarchyEdge(Neighbors[i].Target, Neighbors[j].Target, Cost, NodeIndex));
+					}
+				}
+			}
+		}
+
+		return ShortcutsNum;
+	}
+}
+
+FSpiderNavContractionHierarchy::FSpiderNavContractionHierarchy()
+{
+}
+
+void FSpiderNavContractionHierarchy::Compute(const FSpiderNavGraph& NavGraph, TArray<int32>& OutRanks, TArray<FSpiderNavHierarchyEdge>& OutUpwardEdges)
+{
+	using namespace SpiderNavContraction;
+
+	const int32 NodesNum = NavGraph.Num();
+	OutRanks.Init(INDEX_NONE, NodesNum);
+	OutUpwardEdges.Reset();
+
+	TArray<TArray<FEdge>> Edges;
+	Edges.SetNum(NodesNum);
+	for (int32 From = 0; From != NodesNum; ++From) {
+		for (int32 Edge = NavGraph.GetEdgesBegin(From); Edge != NavGraph.GetEdgesEnd(From); ++Edge) {
+			AddEdge(Edges[From], NavGraph.EdgeTargets[Edge], NavGraph.EdgeCosts[Edge], INDEX_NONE);
+		}
+	}
+
+	FWitnessSearch WitnessSearch;
+	WitnessSearch.Reset(NodesNum);
+
+	// priority is edge difference plus number of contracted neighbors, which spreads contraction evenly over grid
+	TArray<int32> ContractedNeighborsNum;
+	ContractedNeighborsNum.Init(0, NodesNum);
+	auto GetPriority = [&](int32 NodeIndex) {
+		int32 NeighborsNum = 0;
+		for (const FEdge& Edge : Edges[NodeIndex]) {
+			if (OutRanks[Edge.Target] == INDEX_NONE) {
+				NeighborsNum++;
+			}
+		}
+		const int32 ShortcutsNum = ContractNode(Edges, OutRanks, WitnessSearch, NodeIndex, nullptr);
+		return (float)(ShortcutsNum - NeighborsNum + ContractedNeighborsNum[NodeIndex]);
+	};
+
+	TArray<FQueueEntry> Queue;
+	Queue.Reserve(NodesNum);
+	for (int32 i = 0; i != NodesNum; ++i) {
+		Queue.Add({ GetPriority(i), i });
+	}
+	Queue.Heapify();
+
+	TArray<FSpiderNavHierarchyEdge> Shortcuts;
+	int32 NextRank = 0;
+	while (Queue.Num()) {
+		FQueueEntry Entry;
+		Queue.HeapPop(Entry, false);
+
+		// priorities get outdated when neighbors are contracted, so they are updated lazily
+		const float Priority = GetPriority(Entry.Node);
+		if (Queue.Num() && Priority > Queue.HeapTop().Key) {
+			Queue.HeapPush({ Priority, Entry.Node });
+			continue;
+		}
+
+		Shortcuts.Reset();
+		ContractNode(Edges, OutRanks, WitnessSearch, Entry.Node, &Shortcuts);
+		for (const FSpiderNavHierarchyEdge& Shortcut : Shortcuts) {
+			AddEdge(Edges[Shortcut.From], Shortcut.To, Shortcut.Cost, Shortcut.Middle);
+			AddEdge(Edges[Shortcut.To], Shortcut.From, Shortcut.Cost, Shortcut.Middle);
+		}
+
+		// all remaining neighbors get higher ranks, so edges to them are upward ones
+		for (const FEdge& Edge : Edges[Entry.Node]) {
+			if (OutRanks[Edge.Target] == INDEX_NONE) {
+				OutUpwardEdges.Add(FSpiderNavHierarchyEdge(Entry.Node, Edge.Target, Edge.Cost, Edge.Middle));
+				ContractedNeighborsNum[Edge.Target]++;
+			}
+		}
+		OutRanks[Entry.Node] = NextRank++;
+		Edges[Entry.Node].Empty();
+	}
+}
+
+void FSpiderNavContractionHierarchy::Build(TArray<int32>&& InRanks, const TArray<FSpiderNavHierarchyEdge>& InUpwardEdges)
+{
+	Empty();
+
+	const int32 NodesNum = InRanks.Num();
+	Ranks = MoveTemp(InRanks);
+
+	EdgeOffsets.SetNumZeroed(NodesNum + 1);
+	for (const FSpiderNavHierarchyEdge& Edge : InUpwardEdges) {
+		if (!Ranks.IsValidIndex(Edge.From) || !Ranks.IsValidIndex(Edge.To)) {
+			continue;
+		}
+		EdgeOffsets[Edge.From + 1]++;
+	}
+	for (int32 i = 0; i != NodesNum; ++i) {
+		EdgeOffsets[i + 1] += EdgeOffsets[i];
+	}
+
+	TArray<int32> Cursors;
+	Cursors.Append(EdgeOffsets.GetData(), NodesNum);
+
+	const int32 EdgesNum = EdgeOffsets[NodesNum];
+	EdgeTargets.SetNumUninitialized(EdgesNum);
+	EdgeCosts.SetNumUninitialized(EdgesNum);
+	EdgeMiddles.SetNumUninitialized(EdgesNum);
+	for (const FSpiderNavHierarchyEdge& Edge : InUpwardEdges) {
+		if (!Ranks.IsValidIndex(Edge.From) || !Ranks.IsValidIndex(Edge.To)) {
+			continue;
+		}
+		const int32 Index = Cursors[Edge.From]++;
+		EdgeTargets[Index] = Edge.To;
+		EdgeCosts[Index] = Edge.Cost;
+		EdgeMiddles[Index] = Ranks.IsValidIndex(Edge.Middle) ? Edge.Middle : INDEX_NONE;
+	}
+}
+
+void FSpiderNavContractionHierarchy::Empty()
+{
+	Ranks.Empty();
+	EdgeOffsets.Empty();
+	EdgeTargets.Empty();
+	EdgeCosts.Empty();
+	EdgeMiddles.Empty();
+}
+
+bool FSpiderNavContractionHierarchy::FindPath(FSpiderNavSearchContext& ForwardContext, FSpiderNavSearchContext& BackwardContext, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath) const
+{
+	OutPath.Reset();
+	if (StartIndex == EndIndex) {
+		OutPath.Add(StartIndex);
+		return true;
+	}
+
+	FSpiderNavSearchContext* Contexts[2] = { &ForwardContext, &BackwardContext };
+	const int32 SourceIndexes[2] = { StartIndex, EndIndex };
+	for (int32 Direction = 0; Direction < 2; Direction++) {
+		Contexts[Direction]->Reset(Ranks.Num());
+		Contexts[Direction]->GetNode(SourceIndexes[Direction]).bOpened = true;
+		Contexts[Direction]->PushOpenNode(SourceIndexes[Direction]);
+	}
+
+	float BestCost = MAX_flt;
+	int32 MeetingIndex = INDEX_NONE;
+	int32 Direction = 0;
+
+	while (true) {
+		// direction stops when it can not improve the best path anymore
+		bool bCanContinue[2];
+		for (int32 i = 0; i < 2; i++) {
+			bCanContinue[i] = Contexts[i]->HasOpenNodes() && Contexts[i]->FindNode(Contexts[i]->PeekOpenNode())->G < BestCost;
+		}
+		if (!bCanContinue[0] && !bCanContinue[1]) {
+			break;
+		}
+		if (!bCanContinue[Direction]) {
+			Direction = 1 - Direction;
+		}
+
+		FSpiderNavSearchContext& Context = *Contexts[Direction];
+		const FSpiderNavSearchContext& OtherContext = *Contexts[1 - Direction];
+
+		const int32 NodeIndex = Context.PopOpenNode();
+		FSpiderNavSearchNode& SearchNode = Context.GetNode(NodeIndex);
+		SearchNode.bClosed = true;
+
+		const FSpiderNavSearchNode* OtherNode = OtherContext.FindNode(NodeIndex);
+		if (OtherNode && OtherNode->bOpened && SearchNode.G + OtherNode->G < BestCost) {
+			BestCost = SearchNode.G + OtherNode->G;
+			MeetingIndex = NodeIndex;
+		}
+
+		for (int32 Edge = EdgeOffsets[NodeIndex]; Edge != EdgeOffsets[NodeIndex + 1]; ++Edge) {
+			const int32 NeighborIndex = EdgeTargets[Edge];
+			FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+			if (SearchNeighbor.bClosed) {
+				continue;
+			}
+
+			const float NewG = SearchNode.G + EdgeCosts[Edge];
+			if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+				SearchNeighbor.G = NewG;
+				SearchNeighbor.F = NewG;
+				SearchNeighbor.ParentIndex = NodeIndex;
+
+				if (!SearchNeighbor.bOpened) {
+					SearchNeighbor.bOpened = true;
+					Context.PushOpenNode(NeighborIndex);
+				} else {
+					Context.DecreaseOpenNode(NeighborIndex);
+				}
+			}
+		}
+
+		Direction = 1 - Direction;
+	}
+
+	if (MeetingIndex == INDEX_NONE) {
+		return false;
+	}
+
+	// nodes of hierarchy from start up to meeting node, then down to end
+	TArray<int32>& HierarchyPath = ForwardContext.HierarchyPath;
+	HierarchyPath.Reset();
+	for (const FSpiderNavSearchNode* IterNode = ForwardContext.FindNode(MeetingIndex); IterNode && IterNode->ParentIndex > -1; IterNode = ForwardContext.FindNode(IterNode->ParentIndex)) {
+		HierarchyPath.Add(IterNode->ParentIndex);
+	}
+	Algo::Reverse(HierarchyPath);
+	HierarchyPath.Add(MeetingIndex);
+	for (const FSpiderNavSearchNode* IterNode = BackwardContext.FindNode(MeetingIndex); IterNode && IterNode->ParentIndex > -1; IterNode = BackwardContext.FindNode(IterNode->ParentIndex)) {
+		HierarchyPath.Add(IterNode->ParentIndex);
+	}
+
+	OutPath.Add(StartIndex);
+	for (int32 i = 1; i < HierarchyPath.Num(); i++) {
+		UnpackEdge(HierarchyPath[i - 1], HierarchyPath[i], OutPath, ForwardContext.UnpackStack);
+	}
+
+	return true;
+}
+
+void FSpiderNavContractionHierarchy::UnpackEdge(int32 From, int32 To, TArray<int32>& OutPath, TArray<TPair<int32, int32>>& Stack) const
+{
+	Stack.Reset();
+	Stack.Emplace(From, To);
+
+	while (Stack.Num()) {
+		const TPair<int32, int32> Segment = Stack.Pop(false);
+
+		// edge is stored at the node of lower rank
+		const bool bIsUpward = Ranks[Segment.Key] < Ranks[Segment.Value];
+		const int32 Lower = bIsUpward ? Segment.Key : Segment.Value;
+		const int32 Higher = bIsUpward ? Segment.Value : Segment.Key;
+		int32 Middle = INDEX_NONE;
+		for (int32 Edge = EdgeOffsets[Lower]; Edge != EdgeOffsets[Lower + 1]; ++Edge) {
+			if (EdgeTargets[Edge] == Higher) {
+				Middle = EdgeMiddles[Edge];
+				break;
+			}
+		}
+
+		if (Middle == INDEX_NONE) {
+			OutPath.Add(Segment.Value);
+		} else {
+			// the first half has to be unpacked first
+			Stack.Emplace(Middle, Segment.Value);
+			Stack.Emplace(Segment.Key, Middle);
+		}
+	}
+}
@@ -0,0 +1,97 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavFlowField.h"
+#include "SpiderNavigationModule.h"
+
+FSpiderNavFlowField::FSpiderNavFlowField()
+{
+	GraphId = 0;
+	GoalIndex = INDEX_NONE;
+	MaxCost = 0.0f;
+}
+
+void FSpiderNavFlowField::Build(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 InGoalIndex, float InMaxCost)
+{
+	GraphId = NavGraph.Id;
+	GoalIndex = InGoalIndex;
+	MaxCost = InMaxCost > 0.0f ? InMaxCost : MAX_flt;
+
+	NextNodes.Init(INDEX_NONE, NavGraph.Num());
+	Context.Reset(NavGraph.Num());
+
+	Context.GetNode(GoalIndex).bOpened = true;
+	Context.PushOpenNode(GoalIndex);
+
+	while (Context.HasOpenNodes()) {
+		int32 NodeIndex = Context.PopOpenNode();
+		FSpiderNavSearchNode& SearchNode = Context.GetNode(NodeIndex);
+		SearchNode.bClosed = true;
+
+		// the parent is the next hop towards the goal
+		NextNodes[NodeIndex] = SearchNode.ParentIndex;
+
+		const int32 EdgesEnd = NavGraph.GetEdgesEnd(NodeIndex);
+		for (int32 Edge = NavGraph.GetEdgesBegin(NodeIndex); Edge != EdgesEnd; ++Edge) {
+			const int32 NeighborIndex = NavGraph.EdgeTargets[Edge];
+			FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+
+			if (SearchNeighbor.bClosed) {
+				continue;
+			}
+
+			float NewG = SearchNode.G + NavGraph.EdgeCosts[Edge];
+			if (NewG > MaxCost) {
+				continue;
+			}
+
+			if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+				SearchNeighbor.G = NewG;
+				SearchNeighbor.F = NewG;
+				SearchNeighbor.ParentIndex = NodeIndex;
+
+				if (!SearchNeighbor.bOpened) {
+					SearchNeighbor.bOpened = true;
+					Context.PushOpenNode(NeighborIndex);
+				} else {
+					Context.DecreaseOpenNode(NeighborIndex);
+				}
+			}
+		}
+	}
+}
+
+bool FSpiderNavFlowField::Rebase(uint32 OldGraphId, uint32 NewGraphId, TFunctionRef<bool(int32)> IsNodeKept)
+{
+	if (GraphId != OldGraphId) {
+		return false;
+	}
+
+	for (int32 Index = 0; Index != NextNodes.Num(); ++Index) {
+		if ((NextNodes[Index] != INDEX_NONE || Index == GoalIndex) && !IsNodeKept(Index)) {
+			return false;
+		}
+	}
+
+	GraphId = NewGraphId;
+	return true;
+}
@@ -0,0 +1,658 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavGraph.h"
+#include "SpiderNavigationModule.h"
+#include "SpiderNavTiles.h"
+#include "HAL/ThreadSafeCounter.h"
+
+/** Source of unique ids of grids */
+static FThreadSafeCounter GraphIdCounter;
+
+FSpiderNavGraph::FSpiderNavGraph()
+{
+	Id = GraphIdCounter.Increment();
+	QuantizationStep = 0.0f;
+	PreviousId = 0;
+	NodesNum = 0;
+}
+
+void FSpiderNavGraph::Build(TArray<FVector>&& InLocations, TArray<FVector>&& InNormals, const TArray<int32>& InEdgeSources, const TArray<int32>& InEdgeTargets, float GridStepSize)
+{
+	Id = GraphIdCounter.Increment();
+	Locations = MoveTemp(InLocations);
+	Normals = MoveTemp(InNormals);
+	check(Locations.Num() == Normals.Num());
+	check(InEdgeSources.Num() == InEdgeTargets.Num());
+	NodesNum = Locations.Num();
+
+	const int32 EdgesNum = InEdgeSources.Num();
+
+	// count edges of each node, then turn counts into offsets
+	EdgeOffsets.Reset();
+	EdgeOffsets.SetNumZeroed(NodesNum + 1);
+	for (int32 i = 0; i != EdgesNum; ++i) {
+		EdgeOffsets[InEdgeSources[i] + 1]++;
+	}
+	for (int32 i = 0; i != NodesNum; ++i) {
+		EdgeOffsets[i + 1] += EdgeOffsets[i];
+	}
+
+	TArray<int32> Cursors;
+	Cursors.Append(EdgeOffsets.GetData(), NodesNum);
+
+	EdgeTargets.SetNumUninitialized(EdgesNum);
+	for (int32 i = 0; i != EdgesNum; ++i) {
+		EdgeTargets[Cursors[InEdgeSources[i]]++] = InEdgeTargets[i];
+	}
+
+	ComputeEdgeCosts();
+	BuildSpatialIndex(GridStepSize);
+	BuildComponents();
+}
+
+void FSpiderNavGraph::BuildFromRows(TArray<FVector>&& InLocations, TArray<FVector>&& InNormals, TArray<int32>&& InEdgeOffsets, TArray<int32>&& InEdgeTargets, float GridStepSize)
+{
+	Id = GraphIdCounter.Increment();
+	Locations = MoveTemp(InLocations);
+	Normals = MoveTemp(InNormals);
+	EdgeOffsets = MoveTemp(InEdgeOffsets);
+	EdgeTargets = MoveTemp(InEdgeTargets);
+	check(Locations.Num() == Normals.Num());
+	check(EdgeOffsets.Num() == Locations.Num() + 1);
+	NodesNum = Locations.Num();
+
+	ComputeEdgeCosts();
+	BuildSpatialIndex(GridStepSize);
+	BuildComponents();
+}
+
+void FSpiderNavGraph::BuildFromTiles(const TSharedPtr<const FSpiderNavTiles, ESPMode::ThreadSafe>& InTiles, const TArray<int32>& TileIndexes, const FSpiderNavGraph* Previous, bool bQuantize)
+{
+	Empty();
+	Id = GraphIdCounter.Increment();
+	Tiles = InTiles;
+	const FSpiderNavTiles& Source = *InTiles;
+
+	// each streamed tile takes one of 16-bit tiles of quantized locations
+	bQuantize = bQuantize && TileIndexes.Num() <= MAX_uint16 + 1;
+
+	// nodes of previous grid are reused only if it has been stitched from the same tiles in the same form
+	if (Previous && (Previous->Tiles != InTiles || (Previous->Num() > 0 && Previous->IsQuantized() != bQuantize))) {
+		Previous = nullptr;
+	}
+	PreviousId = Previous ? Previous->Id : 0;
+	KeptNodes.Init(false, Previous ? Previous->Num() : 0);
+
+	// pairs of the first node and tile. Tiles which stay streamed in keep their ranges
+	TileFirstNodes.Init(INDEX_NONE, Source.Num());
+	TArray<TPair<int32, int32>> Ranges;
+	TArray<int32> NewTiles;
+	int32 StreamedNodesNum = 0;
+	for (int32 Tile : TileIndexes) {
+		StreamedNodesNum += Source.GetNodesNum(Tile);
+		const int32 First = Previous ? Previous->TileFirstNodes[Tile] : INDEX_NONE;
+		if (First != INDEX_NONE) {
+			TileFirstNodes[Tile] = First;
+			Ranges.Emplace(First, Tile);
+		} else {
+			NewTiles.Add(Tile);
+		}
+	}
+	auto SortRanges = [&Ranges]() {
+		Ranges.Sort([](const TPair<int32, int32>& A, const TPair<int32, int32>& B) {
+			return A.Key < B.Key;
+		});
+	};
+	SortRanges();
+
+	// ranges of tiles which have been streamed out are holes. New tiles fill them first, the biggest tiles first
+	TArray<TPair<int32, int32>> Holes;
+	int32 End = 0;
+	for (const TPair<int32, int32>& Range : Ranges) {
+		if (Range.Key > End) {
+			Holes.Emplace(End, Range.Key - End);
+		}
+		End = Range.Key + Source.GetNodesNum(Range.Value);
+	}
+	NewTiles.Sort([&Source](int32 A, int32 B) {
+		return Source.GetNodesNum(A) > Source.GetNodesNum(B);
+	});
+	for (int32 Tile : NewTiles) {
+		const int32 TileNodesNum = Source.GetNodesNum(Tile);
+		int32 First = INDEX_NONE;
+		for (TPair<int32, int32>& Hole : Holes) {
+			if (Hole.Value >= TileNodesNum) {
+				First = Hole.Key;
+				Hole.Key += TileNodesNum;
+				Hole.Value -= TileNodesNum;
+				break;
+			}
+		}
+		if (First == INDEX_NONE) {
+			First = End;
+			End += TileNodesNum;
+		}
+		TileFirstNodes[Tile] = First;
+		Ranges.Emplace(First, Tile);
+	}
+
+	// nodes left in holes waste memory. When there are more of them than streamed nodes, all tiles are laid out again and no node is kept,
+	// though grid still counts as stitched from previous one
+	if (Previous && End - StreamedNodesNum > StreamedNodesNum) {
+		Previous = nullptr;
+		Ranges.Reset();
+		End = 0;
+		for (int32 Tile : TileIndexes) {
+			TileFirstNodes[Tile] = End;
+			Ranges.Emplace(End, Tile);
+			End += Source.GetNodesNum(Tile);
+		}
+	}
+	SortRanges();
+	NodesNum = End;
+
+	// tile is copied from previous grid if it keeps its range, its edges are copied too if its neighbors keep theirs as well
+	auto IsTileMoved = [this, Previous](int32 Tile) {
+		return !Previous || Previous->TileFirstNodes[Tile] != TileFirstNodes[Tile];
+	};
+	auto IsTileKept = [&Source, &IsTileMoved](int32 Tile) {
+		if (IsTileMoved(Tile)) {
+			return false;
+		}
+		for (int32 Link = Source.LinkOffsets[Tile]; Link != Source.LinkOffsets[Tile + 1]; ++Link) {
+			if (IsTileMoved(Source.Links[Link].NeighborTile)) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	const int32 CopiedNodesNum = Previous ? FMath::Min(NodesNum, Previous->Num()) : 0;
+	if (bQuantize) {
+		// locations of tiles are already quantized, so they are copied as they are
+		QuantizationStep = Source.QuantizationStep;
+		QuantizedLocations.Reserve(NodesNum);
+		QuantizedNormals.Reserve(NodesNum);
+		if (Previous) {
+			QuantizedLocations.Append(Previous->QuantizedLocations.GetData(), CopiedNodesNum);
+			QuantizedNormals.Append(Previous->QuantizedNormals.GetData(), CopiedNodesNum);
+			TileOrigins = Previous->TileOrigins;
+		}
+		QuantizedLocations.SetNumZeroed(NodesNum);
+		QuantizedNormals.SetNumZeroed(NodesNum);
+
+		TBitArray<> UsedOrigins(false, TileOrigins.Num());
+		for (const TPair<int32, int32>& Range : Ranges) {
+			if (!IsTileMoved(Range.Value) && Source.GetNodesNum(Range.Value) > 0) {
+				UsedOrigins[QuantizedLocations[Range.Key].Tile] = true;
+			}
+		}
+
+		for (const TPair<int32, int32>& Range : Ranges) {
+			const int32 Tile = Range.Value;
+			if (!IsTileMoved(Tile)) {
+				continue;
+			}
+
+			int32 Origin = UsedOrigins.Find(false);
+			if (Origin == INDEX_NONE) {
+				Origin = TileOrigins.Add(Source.GetTileOrigin(Tile));
+				UsedOrigins.Add(true);
+			} else {
+				TileOrigins[Origin] = Source.GetTileOrigin(Tile);
+				UsedOrigins[Origin] = true;
+			}
+
+			for (int32 i = 0; i != Source.GetNodesNum(Tile); ++i) {
+				const FSpiderNavTileLocation& TileLocation = Source.Locations[Source.NodeOffsets[Tile] + i];
+				FSpiderNavQuantizedLocation& Quantized = QuantizedLocations[Range.Key + i];
+				Quantized.X = TileLocation.X;
+				Quantized.Y = TileLocation.Y;
+				Quantized.Z = TileLocation.Z;
+				Quantized.Tile = (uint16)Origin;
+				QuantizedNormals[Range.Key + i] = Source.Normals[Source.NodeOffsets[Tile] + i];
+			}
+		}
+	} else {
+		Locations.Reserve(NodesNum);
+		Normals.Reserve(NodesNum);
+		if (Previous) {
+			Locations.Append(Previous->Locations.GetData(), CopiedNodesNum);
+			Normals.Append(Previous->Normals.GetData(), CopiedNodesNum);
+		}
+		Locations.SetNumZeroed(NodesNum);
+		Normals.SetNumZeroed(NodesNum);
+
+		for (const TPair<int32, int32>& Range : Ranges) {
+			const int32 Tile = Range.Value;
+			if (IsTileMoved(Tile)) {
+				for (int32 i = 0; i != Source.GetNodesNum(Tile); ++i) {
+					Locations[Range.Key + i] = Source.GetLocation(Tile, Source.NodeOffsets[Tile] + i);
+					Normals[Range.Key + i] = DecodeNormal(Source.Normals[Source.NodeOffsets[Tile] + i]);
+				}
+			}
+		}
+	}
+
+	EdgeOffsets.Reserve(NodesNum + 1);
+	if (Previous) {
+		EdgeTargets.Reserve(Previous->EdgeTargets.Num());
+		EdgeCosts.Reserve(Previous->EdgeCosts.Num());
+	}
+	EdgeOffsets.Add(0);
+	for (const TPair<int32, int32>& Range : Ranges) {
+		const int32 Tile = Range.Value;
+		const int32 First = Range.Key;
+		const int32 SourceFirst = Source.NodeOffsets[Tile];
+		const int32 TileNodesNum = Source.GetNodesNum(Tile);
+
+		// nodes of holes have no edges
+		while (EdgeOffsets.Num() <= First) {
+			EdgeOffsets.Add(EdgeTargets.Num());
+		}
+
+		if (IsTileKept(Tile)) {
+			const int32 EdgesBegin = Previous->EdgeOffsets[First];
+			const int32 EdgesEnd = Previous->EdgeOffsets[First + TileNodesNum];
+			const int32 Shift = EdgeTargets.Num() - EdgesBegin;
+			for (int32 Node = First + 1; Node <= First + TileNodesNum; ++Node) {
+				EdgeOffsets.Add(Previous->EdgeOffsets[Node] + Shift);
+			}
+			EdgeTargets.Append(Previous->EdgeTargets.GetData() + EdgesBegin, EdgesEnd - EdgesBegin);
+			EdgeCosts.Append(Previous->EdgeCosts.GetData() + EdgesBegin, EdgesEnd - EdgesBegin);
+			for (int32 Node = First; Node != First + TileNodesNum; ++Node) {
+				KeptNodes[Node] = true;
+			}
+			continue;
+		}
+
+		// edges to tiles which are not streamed in are dropped
+		for (int32 i = 0; i != TileNodesNum; ++i) {
+			const int32 SourceNode = SourceFirst + i;
+			const FVector Location = GetLocation(First + i);
+			for (int32 Edge = Source.EdgeOffsets[SourceNode]; Edge != Source.EdgeOffsets[SourceNode + 1]; ++Edge) {
+				const int32 SourceTarget = Source.EdgeTargets[Edge];
+				const int32 TargetTile = SourceTarget >= SourceFirst && SourceTarget < SourceFirst + TileNodesNum ? Tile : Source.FindNodeTile(SourceTarget);
+				if (TileFirstNodes[TargetTile] == INDEX_NONE) {
+					continue;
+				}
+				const int32 Target = TileFirstNodes[TargetTile] + SourceTarget - Source.NodeOffsets[TargetTile];
+				EdgeTargets.Add(Target);
+				EdgeCosts.Add((GetLocation(Target) - Location).Size());
+			}
+			EdgeOffsets.Add(EdgeTargets.Num());
+		}
+	}
+
+	// nodes keep their locations in the index while their tiles keep their ranges
+	if (Previous) {
+		TBitArray<> SameNodes(false, Previous->Num());
+		for (const TPair<int32, int32>& Range : Ranges) {
+			if (!IsTileMoved(Range.Value)) {
+				for (int32 Node = Range.Key; Node != Range.Key + Source.GetNodesNum(Range.Value); ++Node) {
+					SameNodes[Node] = true;
+				}
+			}
+		}
+		SpatialIndex.CopyFrom(Previous->SpatialIndex, [&SameNodes](int32 Node) {
+			return SameNodes[Node];
+		});
+	} else {
+		SpatialIndex.Init(Source.CellSize);
+	}
+
+	TArray<FVector> TileLocations;
+	for (const TPair<int32, int32>& Range : Ranges) {
+		if (IsTileMoved(Range.Value)) {
+			TileLocations.SetNumUninitialized(Source.GetNodesNum(Range.Value), false);
+			for (int32 i = 0; i != TileLocations.Num(); ++i) {
+				TileLocations[i] = GetLocation(Range.Key + i);
+			}
+			SpatialIndex.AddNodes(TileLocations, Range.Key);
+		}
+	}
+
+	// components inside of tiles are merged by links between streamed tiles
+	TArray<int32> Parents;
+	TArray<int32> MergedIds;
+	Parents.SetNumUninitialized(Source.ComponentOffsets.Last());
+	MergedIds.SetNumUninitialized(Source.ComponentOffsets.Last());
+	for (const TPair<int32, int32>& Range : Ranges) {
+		for (int32 Component = Source.ComponentOffsets[Range.Value]; Component != Source.ComponentOffsets[Range.Value + 1]; ++Component) {
+			Parents[Component] = Component;
+			MergedIds[Component] = INDEX_NONE;
+		}
+	}
+
+	auto FindRoot = [&Parents](int32 Component) {
+		while (Parents[Component] != Component) {
+			Parents[Component] = Parents[Parents[Component]];
+			Component = Parents[Component];
+		}
+		return Component;
+	};
+
+	for (const TPair<int32, int32>& Range : Ranges) {
+		for (int32 Link = Source.LinkOffsets[Range.Value]; Link != Source.LinkOffsets[Range.Value + 1]; ++Link) {
+			const FSpiderNavTileLink& TileLink = Source.Links[Link];
+			if (TileFirstNodes[TileLink.NeighborTile] == INDEX_NONE) {
+				continue;
+			}
+			const int32 Root = FindRoot(TileLink.Component);
+			const int32 NeighborRoot = FindRoot(TileLink.NeighborComponent);
+			if (Root != NeighborRoot) {
+				Parents[FMath::Max(Root, NeighborRoot)] = FMath::Min(Root, NeighborRoot);
+			}
+		}
+	}
+
+	// nodes of holes are components of their own like any node without edges
+	ComponentIds.SetNumUninitialized(NodesNum);
+	int32 ComponentsNum = 0;
+	int32 Node = 0;
+	for (const TPair<int32, int32>& Range : Ranges) {
+		for (; Node < Range.Key; ++Node) {
+			ComponentIds[Node] = ComponentsNum++;
+		}
+		for (int32 i = 0; i != Source.GetNodesNum(Range.Value); ++i, ++Node) {
+			int32& MergedId = MergedIds[FindRoot(Source.NodeComponents[Source.NodeOffsets[Range.Value] + i])];
+			if (MergedId == INDEX_NONE) {
+				MergedId = ComponentsNum++;
+			}
+			ComponentIds[Node] = MergedId;
+		}
+	}
+
+	ComponentOffsets.Init(0, ComponentsNum + 1);
+	for (int32 ComponentId : ComponentIds) {
+		ComponentOffsets[ComponentId + 1]++;
+	}
+	for (int32 ComponentId = 0; ComponentId != ComponentsNum; ++ComponentId) {
+		ComponentOffsets[ComponentId + 1] += ComponentOffsets[ComponentId];
+	}
+	TArray<int32> Cursors;
+	Cursors.Append(ComponentOffsets.GetData(), ComponentsNum);
+	ComponentNodes.SetNumUninitialized(NodesNum);
+	for (Node = 0; Node != NodesNum; ++Node) {
+		ComponentNodes[Cursors[ComponentIds[Node]]++] = Node;
+	}
+
+	// landmarks of the whole grid are computed once when it is split into tiles
+	if (!Source.Landmarks.IsEmpty()) {
+		if (Previous) {
+			Landmarks = Previous->Landmarks;
+			Landmarks.SetNodesNum(NodesNum);
+		}
+		for (const TPair<int32, int32>& Range : Ranges) {
+			if (IsTileMoved(Range.Value)) {
+				Landmarks.CopyNodes(Source.Landmarks, Source.NodeOffsets[Range.Value], Range.Key, Source.GetNodesNum(Range.Value));
+			}
+		}
+	}
+}
+
+void FSpiderNavGraph::Empty()
+{
+	Locations.Empty();
+	Normals.Empty();
+	QuantizedLocations.Empty();
+	QuantizedNormals.Empty();
+	TileOrigins.Empty();
+	QuantizationStep = 0.0f;
+	NodesNum = 0;
+	Tiles.Reset();
+	TileFirstNodes.Empty();
+	PreviousId = 0;
+	KeptNodes.Empty();
+	EdgeOffsets.Empty();
+	EdgeTargets.Empty();
+	EdgeCosts.Empty();
+	SpatialIndex.Empty();
+	ComponentIds.Empty();
+	ComponentOffsets.Empty();
+	ComponentNodes.Empty();
+	Clusters.Empty();
+	Landmarks.Empty();
+	ContractionHierarchy.Empty();
+}
+
+void FSpiderNavGraph::ComputeEdgeCosts()
+{
+	EdgeCosts.SetNumUninitialized(EdgeTargets.Num());
+	for (int32 Node = 0; Node != Num(); ++Node) {
+		for (int32 Edge = GetEdgesBegin(Node); Edge != GetEdgesEnd(Node); ++Edge) {
+			EdgeCosts[Edge] = (Locations[EdgeTargets[Edge]] - Locations[Node]).Size();
+		}
+	}
+}
+
+void FSpiderNavGraph::BuildSpatialIndex(float GridStepSize)
+{
+	// old saves do not have step of grid, so take average length of edges instead
+	if (GridStepSize <= 0.0f) {
+		float EdgesLength = 0.0f;
+		for (float EdgeCost : EdgeCosts) {
+			EdgesLength += EdgeCost;
+		}
+		GridStepSize = EdgeCosts.Num() > 0 ? EdgesLength / EdgeCosts.Num() : 100.0f;
+	}
+
+	SpatialIndex.Build(Locations, GridStepSize);
+}
+
+void FSpiderNavGraph::BuildComponents()
+{
+	const int32 NodesNum = Num();
+	ComponentIds.Init(INDEX_NONE, NodesNum);
+	ComponentOffsets.Reset();
+	ComponentOffsets.Add(0);
+	ComponentNodes.Reset();
+	ComponentNodes.Reserve(NodesNum);
+
+	// breadth-first search from each node which has not been labeled yet. Nodes of component are added to ComponentNodes in order of search
+	for (int32 Root = 0; Root != NodesNum; ++Root) {
+		if (ComponentIds[Root] != INDEX_NONE) {
+			continue;
+		}
+
+		const int32 ComponentId = ComponentOffsets.Num() - 1;
+		ComponentIds[Root] = ComponentId;
+		int32 Queued = ComponentNodes.Add(Root);
+		while (Queued < ComponentNodes.Num()) {
+			const int32 Node = ComponentNodes[Queued++];
+			for (int32 Edge = GetEdgesBegin(Node); Edge != GetEdgesEnd(Node); ++Edge) {
+				const int32 Neighbor = EdgeTargets[Edge];
+				if (ComponentIds[Neighbor] == INDEX_NONE) {
+					ComponentIds[Neighbor] = ComponentId;
+					ComponentNodes.Add(Neighbor);
+				}
+			}
+		}
+		ComponentOffsets.Add(ComponentNodes.Num());
+	}
+}
+
+int32 FSpiderNavGraph::FindClosestNodeInComponent(int32 ComponentId, const FVector& Location) const
+{
+	// small components are scanned, large ones take most of nearby cells of spatial index anyway
+	const int32 MaxScannedNodesNum = 1024;
+
+	const int32 First = ComponentOffsets[ComponentId];
+	const int32 Last = ComponentOffsets[ComponentId + 1];
+	if (Last - First > MaxScannedNodesNum) {
+		return SpatialIndex.FindClosest(Location, [this, ComponentId](int32 Node) {
+			return ComponentIds[Node] == ComponentId;
+		});
+	}
+
+	int32 ClosestNode = INDEX_NONE;
+	float ClosestDistanceSquared = MAX_flt;
+	for (int32 i = First; i != Last; ++i) {
+		const float DistanceSquared = FVector::DistSquared(GetLocation(ComponentNodes[i]), Location);
+		if (DistanceSquared < ClosestDistanceSquared) {
+			ClosestDistanceSquared = DistanceSquared;
+			ClosestNode = ComponentNodes[i];
+		}
+	}
+
+	return ClosestNode;
+}
+
+int32 FSpiderNavGraph::FindClosestNodeFromHint(int32 HintNode, const FVector& Location) const
+{
+	// agent moves through a few nodes between updates, more steps mean it has jumped
+	const int32 MaxClimbStepsNum = 4;
+
+	if (HintNode < 0 || HintNode >= Num()) {
+		return SpatialIndex.FindClosest(Location);
+	}
+
+	int32 Node = HintNode;
+	float DistanceSquared = FVector::DistSquared(GetLocation(Node), Location);
+	for (int32 Step = 0; Step < MaxClimbStepsNum; Step++) {
+		int32 CloserNode = INDEX_NONE;
+		float CloserDistanceSquared = DistanceSquared;
+		float LongestEdgeCost = 0.0f;
+
+		const int32 EdgesEnd = GetEdgesEnd(Node);
+		for (int32 Edge = GetEdgesBegin(Node); Edge != EdgesEnd; ++Edge) {
+			LongestEdgeCost = FMath::Max(LongestEdgeCost, EdgeCosts[Edge]);
+			const float NeighborDistanceSquared = FVector::DistSquared(GetLocation(EdgeTargets[Edge]), Location);
+			if (NeighborDistanceSquared < CloserDistanceSquared) {
+				CloserDistanceSquared = NeighborDistanceSquared;
+				CloserNode = EdgeTargets[Edge];
+			}
+		}
+
+		if (CloserNode == INDEX_NONE) {
+			// local minimum far from location can be a node of another surface, edges of the node tell how far its neighborhood is
+			if (DistanceSquared <= FMath::Square(LongestEdgeCost)) {
+				return Node;
+			}
+			break;
+		}
+
+		Node = CloserNode;
+		DistanceSquared = CloserDistanceSquared;
+	}
+
+	return SpatialIndex.FindClosest(Location);
+}
+
+int32 FSpiderNavGraph::FindStreamingTile(const FVector& Location) const
+{
+	return Tiles.IsValid() ? Tiles->FindTile(Location) : INDEX_NONE;
+}
+
+bool FSpiderNavGraph::Quantize(float Step)
+{
+	if (IsQuantized() || Step <= 0.0f) {
+		return false;
+	}
+
+	// the largest offset is kept below MAX_uint16, so rounding of it can not overflow
+	const float TileSize = Step * (MAX_uint16 - 1);
+
+	TMap<FIntVector, int32> TilesByCoords;
+	TArray<FVector> NewTileOrigins;
+	TArray<FSpiderNavQuantizedLocation> NewLocations;
+	NewLocations.SetNumUninitialized(NodesNum);
+	for (int32 i = 0; i != NodesNum; ++i) {
+		const FVector& Location = Locations[i];
+		const FIntVector TileCoords(FMath::FloorToInt(Location.X / TileSize), FMath::FloorToInt(Location.Y / TileSize), FMath::FloorToInt(Location.Z / TileSize));
+		int32* Tile = TilesByCoords.Find(TileCoords);
+		if (!Tile) {
+			if (NewTileOrigins.Num() > MAX_uint16) {
+				return false;
+			}
+			Tile = &TilesByCoords.Add(TileCoords, NewTileOrigins.Add(FVector(TileCoords) * TileSize));
+		}
+
+		const FVector Offset = (Location - NewTileOrigins[*Tile]) / Step;
+		FSpiderNavQuantizedLocation& Quantized = NewLocations[i];
+		Quantized.X = (uint16)FMath::Clamp(FMath::RoundToInt(Offset.X), 0, (int32)MAX_uint16);
+		Quantized.Y = (uint16)FMath::Clamp(FMath::RoundToInt(Offset.Y), 0, (int32)MAX_uint16);
+		Quantized.Z = (uint16)FMath::Clamp(FMath::RoundToInt(Offset.Z), 0, (int32)MAX_uint16);
+		Quantized.Tile = (uint16)*Tile;
+	}
+
+	QuantizedNormals.SetNumUninitialized(NodesNum);
+	for (int32 i = 0; i != NodesNum; ++i) {
+		QuantizedNormals[i] = EncodeNormal(Normals[i]);
+	}
+
+	QuantizedLocations = MoveTemp(NewLocations);
+	TileOrigins = MoveTemp(NewTileOrigins);
+	QuantizationStep = Step;
+	Locations.Empty();
+	Normals.Empty();
+
+	return true;
+}
+
+SIZE_T FSpiderNavGraph::GetAllocatedSize() const
+{
+	return Locations.GetAllocatedSize() + Normals.GetAllocatedSize()
+		+ QuantizedLocations.GetAllocatedSize() + QuantizedNormals.GetAllocatedSize() + TileOrigins.GetAllocatedSize()
+		+ EdgeOffsets.GetAllocatedSize() + EdgeTargets.GetAllocatedSize() + EdgeCosts.GetAllocatedSize()
+		+ ComponentIds.GetAllocatedSize() + ComponentOffsets.GetAllocatedSize() + ComponentNodes.GetAllocatedSize()
+		+ SpatialIndex.GetAllocatedSize() + Clusters.GetAllocatedSize() + Landmarks.GetAllocatedSize() + ContractionHierarchy.GetAllocatedSize()
+		+ TileFirstNodes.GetAllocatedSize() + KeptNodes.GetAllocatedSize();
+}
+
+uint16 FSpiderNavGraph::EncodeNormal(const FVector& Normal)
+{
+	const float Norm = FMath::Abs(Normal.X) + FMath::Abs(Normal.Y) + FMath::Abs(Normal.Z);
+	if (Norm < SMALL_NUMBER) {
+		return EncodeNormal(FVector::UpVector);
+	}
+
+	// upper half of octahedron is projected onto the square directly, lower half is folded over its diagonals
+	float U = Normal.X / Norm;
+	float V = Normal.Y / Norm;
+	if (Normal.Z < 0.0f) {
+		const float FoldedU = (1.0f - FMath::Abs(V)) * (U >= 0.0f ? 1.0f : -1.0f);
+		const float FoldedV = (1.0f - FMath::Abs(U)) * (V >= 0.0f ? 1.0f : -1.0f);
+		U = FoldedU;
+		V = FoldedV;
+	}
+
+	const uint8 EncodedU = (uint8)FMath::Clamp(FMath::RoundToInt((U * 0.5f + 0.5f) * 255.0f), 0, 255);
+	const uint8 EncodedV = (uint8)FMath::Clamp(FMath::RoundToInt((V * 0.5f + 0.5f) * 255.0f), 0, 255);
+
+	return ((uint16)EncodedU << 8) | EncodedV;
+}
+
+FVector FSpiderNavGraph::DecodeNormal(uint16 Encoded)
+{
+	const float U = (Encoded >> 8) / 255.0f * 2.0f - 1.0f;
+	const float V = (Encoded & 0xFF) / 255.0f * 2.0f - 1.0f;
+
+	FVector Normal(U, V, 1.0f - FMath::Abs(U) - FMath::Abs(V));
+	if (Normal.Z < 0.0f) {
+		Normal.X = (1.0f - FMath::Abs(V)) * (U >= 0.0f ? 1.0f : -1.0f);
+		Normal.Y = (1.0f - FMath::Abs(U)) * (V >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return Normal.GetSafeNormal();
+}
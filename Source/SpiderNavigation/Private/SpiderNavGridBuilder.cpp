@@ -22,6 +22,10 @@
 
 #include "SpiderNavGridBuilder.h"
 #include "SpiderNavigationModule.h"
+#include "SpiderNavGraph.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
 
 DEFINE_LOG_CATEGORY(SpiderNAVGRID_LOG);
 
@@ -54,6 +58,11 @@ ASpiderNavGridBuilder::ASpiderNavGridBuilder()
 	ConnectionSphereRadiusModificator = 1.5f;
 	TraceDistanceForEdgesModificator = 1.9f;
 	EgdeDeviationModificator = 0.15f;
+	bBuildClusters = true;
+	ClusterSizeModificator = 10.0f;
+	bBuildContractionHierarchy = true;
+	bSaveToSaveGame = false;
+	bSaveToAsset = true;
 	TracersInVolumesCheckDistance = 100000.0f;
 	bShouldTryToRemoveTracersEnclosedInVolumes = false;
 }
@@ -617,29 +626,123 @@ void ASpiderNavGridBuilder::RemoveAllTracers()
 
 void ASpiderNavGridBuilder::SaveGrid()
 {
-	TMap<int32, FVector> NavLocations;
-	TMap<int32, FVector> NavNormals;
-	TMap<int32, FSpiderNavRelations> NavRelations;
+	TArray<FVector> Locations;
+	TArray<FVector> Normals;
+	TArray<int32> EdgeSources;
+	TArray<int32> EdgeTargets;
 
 	ASpiderNavPoint* NavPoint = NULL;
-	ASpiderNavPoint* NeighborNavPoint = NULL;
 
 	for (int32 i = 0; i < NavPoints.Num(); ++i) {
 		NavPoint = NavPoints[i];
-		NavLocations.Add(i, NavPoint->GetActorLocation());
-		NavNormals.Add(i, NavPoint->Normal);
-		FSpiderNavRelations SpiderNavRelations;
+		Locations.Add(NavPoint->GetActorLocation());
+		Normals.Add(NavPoint->Normal);
 		for (int32 j = 0; j < NavPoint->Neighbors.Num(); ++j) {
 			int32 NeighborIndex = GetNavPointIndex(NavPoint->Neighbors[j]);
-			SpiderNavRelations.Neighbors.Add(NeighborIndex);
+			if (NeighborIndex != -1) {
+				EdgeSources.Add(i);
+				EdgeTargets.Add(NeighborIndex);
+			}
 		}
-		NavRelations.Add(i, SpiderNavRelations);
 	}
 
+	FSpiderNavGraph NavGraph;
+	NavGraph.Build(MoveTemp(Locations), MoveTemp(Normals), EdgeSources, EdgeTargets, GridStepSize);
+
+	FSpiderNavGridData GridData;
+	GridData.GridStepSize = GridStepSize;
+	GridData.Locations = NavGraph.Locations;
+	GridData.Normals = NavGraph.Normals;
+	GridData.EdgeOffsets = NavGraph.EdgeOffsets;
+	GridData.EdgeTargets = NavGraph.EdgeTargets;
+
+	if (bBuildClusters && NavGraph.Num()) {
+		FSpiderNavClusters::Compute(NavGraph, GridStepSize * ClusterSizeModificator, GridData.ClusterIds, GridData.AbstractEdges);
+		UE_LOG(SpiderNAVGRID_LOG, Log, TEXT("Abstract edges between clusters: %d"), GridData.AbstractEdges.Num());
+	}
+
+	if (bBuildContractionHierarchy && NavGraph.Num()) {
+		FSpiderNavContractionHierarchy::Compute(NavGraph, GridData.Ranks, GridData.HierarchyEdges);
+		UE_LOG(SpiderNAVGRID_LOG, Log, TEXT("Edges of contraction hierarchy: %d"), GridData.HierarchyEdges.Num());
+	}
+
+	const FString Filename = FSpiderNavGridData::GetDefaultFilename();
+	if (GridData.SaveToFile(Filename)) {
+		UE_LOG(SpiderNAVGRID_LOG, Log, TEXT("Grid has been saved to %s"), *Filename);
+	} else {
+		UE_LOG(SpiderNAVGRID_LOG, Error, TEXT("Can not save grid to %s"), *Filename);
+	}
+
+	if (bSaveToSaveGame) {
+		SaveGridToSaveGame(GridData);
+	}
+
+	if (bSaveToAsset) {
+		SaveGridToAsset(GridData);
+	}
+}
+
+bool ASpiderNavGridBuilder::SaveGridToAsset(const FSpiderNavGridData& GridData)
+{
+#if WITH_EDITOR
+	FString PackageName;
+	FString AssetName;
+	if (GridAsset.IsNull()) {
+		// one asset per map
+		AssetName = FPackageName::GetShortName(UWorld::RemovePIEPrefix(GetOutermost()->GetName())) + TEXT("_SpiderNavGrid");
+		PackageName = TEXT("/Game/SpiderNavigation/") + AssetName;
+	} else {
+		PackageName = GridAsset.GetLongPackageName();
+		AssetName = GridAsset.GetAssetName();
+	}
+
+	USpiderNavGridAsset* Asset = LoadObject<USpiderNavGridAsset>(nullptr, *(PackageName + TEXT(".") + AssetName), nullptr, LOAD_NoWarn | LOAD_Quiet);
+	if (!Asset) {
+		UPackage* NewPackage = CreatePackage(nullptr, *PackageName);
+		Asset = NewObject<USpiderNavGridAsset>(NewPackage, *AssetName, RF_Public | RF_Standalone);
+	}
+
+	Asset->GridData = GridData;
+	Asset->MarkPackageDirty();
+
+	const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+	if (!UPackage::SavePackage(Asset->GetOutermost(), Asset, RF_Public | RF_Standalone, *Filename)) {
+		UE_LOG(SpiderNAVGRID_LOG, Error, TEXT("Can not save grid asset to %s"), *Filename);
+		return false;
+	}
+
+	GridAsset = Asset;
+	UE_LOG(SpiderNAVGRID_LOG, Log, TEXT("Grid has been saved to asset %s. Set it as GridAsset of SpiderNavigation of the map"), *PackageName);
+	return true;
+#else
+	UE_LOG(SpiderNAVGRID_LOG, Warning, TEXT("Grid asset can be written only in editor"));
+	return false;
+#endif
+}
+
+void ASpiderNavGridBuilder::SaveGridToSaveGame(const FSpiderNavGridData& GridData)
+{
 	USpiderNavGridSaveGame* SaveGameInstance = Cast<USpiderNavGridSaveGame>(UGameplayStatics::CreateSaveGameObject(USpiderNavGridSaveGame::StaticClass()));
-	SaveGameInstance->NavLocations = NavLocations;
-	SaveGameInstance->NavNormals = NavNormals;
-	SaveGameInstance->NavRelations = NavRelations;
+	SaveGameInstance->GridStepSize = GridData.GridStepSize;
+
+	for (int32 i = 0; i < GridData.Locations.Num(); ++i) {
+		SaveGameInstance->NavLocations.Add(i, GridData.Locations[i]);
+		SaveGameInstance->NavNormals.Add(i, GridData.Normals[i]);
+		FSpiderNavRelations SpiderNavRelations;
+		SpiderNavRelations.Neighbors.Append(GridData.EdgeTargets.GetData() + GridData.EdgeOffsets[i], GridData.EdgeOffsets[i + 1] - GridData.EdgeOffsets[i]);
+		SaveGameInstance->NavRelations.Add(i, SpiderNavRelations);
+	}
+
+	for (int32 i = 0; i < GridData.ClusterIds.Num(); ++i) {
+		SaveGameInstance->NavClusters.Add(i, GridData.ClusterIds[i]);
+	}
+	SaveGameInstance->NavAbstractEdges = GridData.AbstractEdges;
+
+	for (int32 i = 0; i < GridData.Ranks.Num(); ++i) {
+		SaveGameInstance->NavRanks.Add(i, GridData.Ranks[i]);
+	}
+	SaveGameInstance->NavHierarchyEdges = GridData.HierarchyEdges;
+
 	UGameplayStatics::SaveGameToSlot(SaveGameInstance, SaveGameInstance->SaveSlotName, SaveGameInstance->UserIndex);
 }
 
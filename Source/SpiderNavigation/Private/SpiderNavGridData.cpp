@@ -0,0 +1,146 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavGridData.h"
+#include "SpiderNavigationModule.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+const uint32 FSpiderNavGridData::Magic = 0x474E5053;
+
+const int32 FSpiderNavGridData::Version = 1;
+
+FSpiderNavGridData::FSpiderNavGridData()
+{
+	GridStepSize = 0.0f;
+}
+
+bool FSpiderNavGridData::Serialize(FArchive& Ar)
+{
+	uint32 FileMagic = Magic;
+	int32 FileVersion = Version;
+	Ar << FileMagic;
+	Ar << FileVersion;
+	if (Ar.IsError() || FileMagic != Magic || FileVersion != Version) {
+		return false;
+	}
+
+	// arrays of plain values are copied as whole blocks of memory when loading
+	Ar << GridStepSize;
+	Locations.BulkSerialize(Ar);
+	Normals.BulkSerialize(Ar);
+	EdgeOffsets.BulkSerialize(Ar);
+	EdgeTargets.BulkSerialize(Ar);
+	ClusterIds.BulkSerialize(Ar);
+	AbstractEdges.BulkSerialize(Ar);
+	Ranks.BulkSerialize(Ar);
+	HierarchyEdges.BulkSerialize(Ar);
+
+	if (Ar.IsError()) {
+		return false;
+	}
+
+	return Ar.IsSaving() || IsValid();
+}
+
+bool FSpiderNavGridData::SaveToFile(const FString& Filename)
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer.IsValid()) {
+		return false;
+	}
+
+	const bool bSerialized = Serialize(*Writer);
+	return Writer->Close() && bSerialized;
+}
+
+bool FSpiderNavGridData::LoadFromFile(const FString& Filename)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename, FILEREAD_Silent));
+	if (!Reader.IsValid()) {
+		return false;
+	}
+
+	if (!Serialize(*Reader)) {
+		Empty();
+		return false;
+	}
+
+	return true;
+}
+
+bool FSpiderNavGridData::IsValid() const
+{
+	const int32 NodesNum = Locations.Num();
+	if (Normals.Num() != NodesNum || EdgeOffsets.Num() != NodesNum + 1 || EdgeOffsets[0] != 0 || EdgeOffsets[NodesNum] != EdgeTargets.Num()) {
+		return false;
+	}
+	if ((ClusterIds.Num() && ClusterIds.Num() != NodesNum) || (Ranks.Num() && Ranks.Num() != NodesNum)) {
+		return false;
+	}
+
+	for (int32 i = 0; i != NodesNum; ++i) {
+		if (EdgeOffsets[i] > EdgeOffsets[i + 1]) {
+			return false;
+		}
+	}
+	for (int32 Target : EdgeTargets) {
+		if (!Locations.IsValidIndex(Target)) {
+			return false;
+		}
+	}
+	for (int32 ClusterId : ClusterIds) {
+		if (ClusterId < 0) {
+			return false;
+		}
+	}
+	for (const FSpiderNavAbstractEdge& Edge : AbstractEdges) {
+		if (!Locations.IsValidIndex(Edge.From) || !Locations.IsValidIndex(Edge.To)) {
+			return false;
+		}
+	}
+	for (const FSpiderNavHierarchyEdge& Edge : HierarchyEdges) {
+		if (!Locations.IsValidIndex(Edge.From) || !Locations.IsValidIndex(Edge.To) || (Edge.Middle != INDEX_NONE && !Locations.IsValidIndex(Edge.Middle))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FSpiderNavGridData::Empty()
+{
+	GridStepSize = 0.0f;
+	Locations.Empty();
+	Normals.Empty();
+	EdgeOffsets.Empty();
+	EdgeTargets.Empty();
+	ClusterIds.Empty();
+	AbstractEdges.Empty();
+	Ranks.Empty();
+	HierarchyEdges.Empty();
+}
+
+FString FSpiderNavGridData::GetDefaultFilename()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SpiderNavigation"), TEXT("SpiderNavGrid.bin"));
+}
@@ -27,4 +27,5 @@ USpiderNavGridSaveGame::USpiderNavGridSaveGame()
 {
 	SaveSlotName = TEXT("SpiderNavGrid");
 	UserIndex = 0;
+	GridStepSize = 0.0f;
 }
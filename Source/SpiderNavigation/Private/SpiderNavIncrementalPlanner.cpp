@@ -0,0 +1,413 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavIncrementalPlanner.h"
+#include "SpiderNavigationModule.h"
+
+FSpiderNavIncrementalPlanner::FSpiderNavIncrementalPlanner()
+{
+	ExpandedNodesNum = 0;
+	KeptNodesNum = 0;
+	Reset();
+}
+
+void FSpiderNavIncrementalPlanner::Reset()
+{
+	Nodes.Empty();
+	SlotsTable.Empty();
+	SlotsBits = 0;
+	OpenList.Empty();
+	KeptSlots.Empty();
+	GraphId = 0;
+	RootIndex = INDEX_NONE;
+	StartIndex = INDEX_NONE;
+	GoalIndex = INDEX_NONE;
+	GoalLocation = FVector::ZeroVector;
+	KeyModifier = 0.0f;
+	OverLimitDistance = MAX_flt;
+}
+
+void FSpiderNavIncrementalPlanner::Rebase(uint32 OldGraphId, uint32 NewGraphId, TFunctionRef<bool(int32)> IsNodeKept)
+{
+	// goal over limit can be closer in new grid
+	if (GraphId != OldGraphId || OverLimitDistance < MAX_flt) {
+		Reset();
+		return;
+	}
+
+	for (const FPlannerNode& Node : Nodes) {
+		if (!IsNodeKept(Node.Index)) {
+			Reset();
+			return;
+		}
+	}
+
+	GraphId = NewGraphId;
+}
+
+int32 FSpiderNavIncrementalPlanner::FindNextNode(const FSpiderNavGraph& NavGraph, int32 InStartIndex, int32 EndIndex, int32 MaxNodesNum)
+{
+	ExpandedNodesNum = 0;
+	KeptNodesNum = 0;
+	if (InStartIndex == INDEX_NONE || EndIndex == INDEX_NONE || InStartIndex == EndIndex) {
+		return INDEX_NONE;
+	}
+
+	const FVector EndLocation = NavGraph.GetLocation(EndIndex);
+	const float Distance = (NavGraph.GetLocation(InStartIndex) - EndLocation).Size();
+	if (GraphId == NavGraph.Id && Distance >= OverLimitDistance) {
+		return INDEX_NONE;
+	}
+
+	if (EndIndex != GoalIndex) {
+		// heuristic of any node changes by no more than distance which the goal has moved by
+		if (GoalIndex != INDEX_NONE) {
+			KeyModifier += (EndLocation - GoalLocation).Size();
+		}
+		GoalIndex = EndIndex;
+		GoalLocation = EndLocation;
+	}
+
+	// cost of closed node of the agent is exact, so the tree is continued from it
+	StartIndex = InStartIndex;
+	const int32 StartSlot = GraphId == NavGraph.Id ? FindSlot(StartIndex) : INDEX_NONE;
+	bool bNewTree = false;
+	if (StartSlot == INDEX_NONE || !Nodes[StartSlot].bClosed) {
+		Restart(NavGraph, StartIndex);
+		bNewTree = true;
+	}
+
+	// the agent which follows the path stays in the tree, then the closed goal which is still on it needs no search
+	const int32 GoalSlot = FindSlot(GoalIndex);
+	if (GoalSlot != INDEX_NONE && Nodes[GoalSlot].bClosed) {
+		const int32 NextIndex = FindNodeAfterStart();
+		if (NextIndex != INDEX_NONE) {
+			return NextIndex;
+		}
+	}
+
+	// otherwise search from the old root could only find paths around the agent, so only subtree of the agent is needed
+	if (RootIndex != StartIndex) {
+		CutTree(NavGraph);
+	}
+	bool bFound = Search(NavGraph, MaxNodesNum);
+
+	const bool bOverLimit = !bFound && MaxNodesNum > 0 && Nodes.Num() > MaxNodesNum;
+	if (bOverLimit && !bNewTree) {
+		// most of the tree could have been grown for old goals, the new one is only as big as the current path needs
+		const int32 OldExpandedNodesNum = ExpandedNodesNum;
+		Restart(NavGraph, StartIndex);
+		bFound = Search(NavGraph, MaxNodesNum);
+		ExpandedNodesNum += OldExpandedNodesNum;
+	}
+
+	if (!bFound) {
+		if (MaxNodesNum > 0 && Nodes.Num() > MaxNodesNum) {
+			Reset();
+			GraphId = NavGraph.Id;
+			OverLimitDistance = Distance;
+		}
+		return INDEX_NONE;
+	}
+
+	return FindNodeAfterStart();
+}
+
+void FSpiderNavIncrementalPlanner::Restart(const FSpiderNavGraph& NavGraph, int32 InRootIndex)
+{
+	Nodes.Reset();
+	OpenList.Reset();
+	RebuildSlots(0);
+	GraphId = NavGraph.Id;
+	RootIndex = InRootIndex;
+	KeyModifier = 0.0f;
+	OverLimitDistance = MAX_flt;
+
+	bool bAdded = false;
+	PushOpenSlot(GetSlot(RootIndex, bAdded));
+}
+
+void FSpiderNavIncrementalPlanner::CutTree(const FSpiderNavGraph& NavGraph)
+{
+	const int32 StartSlot = FindSlot(StartIndex);
+	const int32 NodesNum = Nodes.Num();
+
+	// closed node is kept if the agent is its ancestor. Marks are INDEX_NONE for nodes which are not kept, 1 for kept ones and 0 for unknown ones
+	KeptSlots.Init(0, NodesNum);
+	KeptSlots[StartSlot] = 1;
+	for (int32 Slot = 0; Slot != NodesNum; ++Slot) {
+		if (!Nodes[Slot].bClosed) {
+			KeptSlots[Slot] = INDEX_NONE;
+			continue;
+		}
+
+		// ancestors are found once, then the mark is written along the way to them
+		int32 Ancestor = Slot;
+		while (Ancestor != INDEX_NONE && KeptSlots[Ancestor] == 0) {
+			Ancestor = Nodes[Ancestor].ParentSlot;
+		}
+		const int32 Mark = Ancestor != INDEX_NONE ? KeptSlots[Ancestor] : INDEX_NONE;
+		for (int32 Marked = Slot; Marked != Ancestor; Marked = Nodes[Marked].ParentSlot) {
+			KeptSlots[Marked] = Mark;
+		}
+	}
+
+	// kept nodes are moved to the beginning keeping their order. Paths from the agent are suffixes of paths from the old root, so costs only lose cost of the agent's node
+	int32 KeptNum = 0;
+	for (int32 Slot = 0; Slot != NodesNum; ++Slot) {
+		if (KeptSlots[Slot] != INDEX_NONE) {
+			KeptSlots[Slot] = KeptNum++;
+		}
+	}
+
+	const float StartG = Nodes[StartSlot].G;
+	for (int32 Slot = 0; Slot != NodesNum; ++Slot) {
+		const int32 NewSlot = KeptSlots[Slot];
+		if (NewSlot == INDEX_NONE) {
+			continue;
+		}
+		FPlannerNode Node = Nodes[Slot];
+		Node.G -= StartG;
+		Node.ParentSlot = Slot != StartSlot ? KeptSlots[Node.ParentSlot] : INDEX_NONE;
+		Node.HeapIndex = INDEX_NONE;
+		Nodes[NewSlot] = Node;
+	}
+	Nodes.SetNum(KeptNum, false);
+	RebuildSlots(KeptNum);
+
+	RootIndex = StartIndex;
+	KeyModifier = 0.0f;
+	KeptNodesNum = KeptNum;
+
+	// neighbors of kept nodes which are not kept are the open list of the cut tree, they get the best costs from kept nodes without expansions
+	OpenList.Reset();
+	for (int32 Slot = 0; Slot != KeptNum; ++Slot) {
+		const int32 NodeIndex = Nodes[Slot].Index;
+		const float G = Nodes[Slot].G;
+		const int32 EdgesEnd = NavGraph.GetEdgesEnd(NodeIndex);
+		for (int32 Edge = NavGraph.GetEdgesBegin(NodeIndex); Edge != EdgesEnd; ++Edge) {
+			bool bAdded = false;
+			FPlannerNode& Neighbor = Nodes[GetSlot(NavGraph.EdgeTargets[Edge], bAdded)];
+			const float NewG = G + NavGraph.EdgeCosts[Edge];
+			if (bAdded || (!Neighbor.bClosed && NewG < Neighbor.G)) {
+				Neighbor.G = NewG;
+				Neighbor.ParentSlot = Slot;
+			}
+		}
+	}
+	for (int32 Slot = KeptNum; Slot != Nodes.Num(); ++Slot) {
+		Nodes[Slot].Key = GetKey(NavGraph, Nodes[Slot]);
+		PushOpenSlot(Slot);
+	}
+}
+
+bool FSpiderNavIncrementalPlanner::Search(const FSpiderNavGraph& NavGraph, int32 MaxNodesNum)
+{
+	const int32 GoalSlot = FindSlot(GoalIndex);
+	if (GoalSlot != INDEX_NONE && Nodes[GoalSlot].bClosed) {
+		return true;
+	}
+
+	while (OpenList.Num()) {
+		if (MaxNodesNum > 0 && Nodes.Num() > MaxNodesNum) {
+			return false;
+		}
+
+		const int32 Slot = OpenList[0];
+
+		// the key could have been computed for one of previous goals, then it is only a lower bound
+		const float Key = GetKey(NavGraph, Nodes[Slot]);
+		if (Nodes[Slot].Key < Key) {
+			Nodes[Slot].Key = Key;
+			SiftDown(0);
+			continue;
+		}
+
+		const int32 Last = OpenList.Pop(false);
+		if (OpenList.Num()) {
+			OpenList[0] = Last;
+			SiftDown(0);
+		}
+		Nodes[Slot].HeapIndex = INDEX_NONE;
+		Nodes[Slot].bClosed = true;
+		ExpandedNodesNum++;
+
+		const int32 NodeIndex = Nodes[Slot].Index;
+		const float G = Nodes[Slot].G;
+		const int32 EdgesEnd = NavGraph.GetEdgesEnd(NodeIndex);
+		for (int32 Edge = NavGraph.GetEdgesBegin(NodeIndex); Edge != EdgesEnd; ++Edge) {
+			// GetSlot can reallocate Nodes, so references to them are taken after it
+			bool bAdded = false;
+			const int32 NeighborSlot = GetSlot(NavGraph.EdgeTargets[Edge], bAdded);
+			FPlannerNode& Neighbor = Nodes[NeighborSlot];
+			if (Neighbor.bClosed) {
+				continue;
+			}
+
+			const float NewG = G + NavGraph.EdgeCosts[Edge];
+			if (bAdded || NewG < Neighbor.G) {
+				Neighbor.G = NewG;
+				Neighbor.Key = GetKey(NavGraph, Neighbor);
+				Neighbor.ParentSlot = Slot;
+
+				if (bAdded) {
+					PushOpenSlot(NeighborSlot);
+				} else {
+					SiftUp(Neighbor.HeapIndex);
+				}
+			}
+		}
+
+		// the goal is checked after its neighbors are opened, so the search can be continued for the next goal from any closed node
+		if (NodeIndex == GoalIndex) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+int32 FSpiderNavIncrementalPlanner::FindNodeAfterStart() const
+{
+	int32 NextIndex = INDEX_NONE;
+	for (int32 Slot = FindSlot(GoalIndex); Slot != INDEX_NONE; Slot = Nodes[Slot].ParentSlot) {
+		if (Nodes[Slot].Index == StartIndex) {
+			return NextIndex;
+		}
+		NextIndex = Nodes[Slot].Index;
+	}
+	return INDEX_NONE;
+}
+
+int32 FSpiderNavIncrementalPlanner::FindSlot(int32 Index) const
+{
+	if (!SlotsTable.Num()) {
+		return INDEX_NONE;
+	}
+
+	const uint32 Mask = SlotsTable.Num() - 1;
+	for (uint32 Position = GetSlotsPosition(Index); ; Position = (Position + 1) & Mask) {
+		const int32 Slot = SlotsTable[Position];
+		if (Slot == INDEX_NONE || Nodes[Slot].Index == Index) {
+			return Slot;
+		}
+	}
+}
+
+int32 FSpiderNavIncrementalPlanner::GetSlot(int32 Index, bool& bAdded)
+{
+	// table is kept at most half full, so probes stay short
+	if ((Nodes.Num() + 1) * 2 > SlotsTable.Num()) {
+		RebuildSlots(Nodes.Num() + 1);
+	}
+
+	const uint32 Mask = SlotsTable.Num() - 1;
+	uint32 Position = GetSlotsPosition(Index);
+	for (; SlotsTable[Position] != INDEX_NONE; Position = (Position + 1) & Mask) {
+		if (Nodes[SlotsTable[Position]].Index == Index) {
+			bAdded = false;
+			return SlotsTable[Position];
+		}
+	}
+
+	FPlannerNode Node;
+	Node.Index = Index;
+	Node.G = 0.0f;
+	Node.Key = 0.0f;
+	Node.ParentSlot = INDEX_NONE;
+	Node.HeapIndex = INDEX_NONE;
+	Node.bClosed = false;
+
+	bAdded = true;
+	SlotsTable[Position] = Nodes.Add(Node);
+	return SlotsTable[Position];
+}
+
+void FSpiderNavIncrementalPlanner::RebuildSlots(int32 NodesNum)
+{
+	SlotsBits = 4;
+	while ((1 << SlotsBits) < NodesNum * 2) {
+		SlotsBits++;
+	}
+	SlotsTable.Init(INDEX_NONE, 1 << SlotsBits);
+
+	const uint32 Mask = SlotsTable.Num() - 1;
+	for (int32 Slot = 0; Slot != Nodes.Num(); ++Slot) {
+		uint32 Position = GetSlotsPosition(Nodes[Slot].Index);
+		while (SlotsTable[Position] != INDEX_NONE) {
+			Position = (Position + 1) & Mask;
+		}
+		SlotsTable[Position] = Slot;
+	}
+}
+void FSpiderNavIncrementalPlanner::PushOpenSlot(int32 Slot)
+{
+	const int32 Position = OpenList.Add(Slot);
+	Nodes[Slot].HeapIndex = Position;
+	SiftUp(Position);
+}
+
+void FSpiderNavIncrementalPlanner::SiftUp(int32 Position)
+{
+	const int32 Slot = OpenList[Position];
+	const float Key = Nodes[Slot].Key;
+
+	while (Position > 0) {
+		const int32 ParentPosition = (Position - 1) / 2;
+		const int32 ParentSlot = OpenList[ParentPosition];
+		if (Nodes[ParentSlot].Key <= Key) {
+			break;
+		}
+		OpenList[Position] = ParentSlot;
+		Nodes[ParentSlot].HeapIndex = Position;
+		Position = ParentPosition;
+	}
+
+	OpenList[Position] = Slot;
+	Nodes[Slot].HeapIndex = Position;
+}
+
+void FSpiderNavIncrementalPlanner::SiftDown(int32 Position)
+{
+	const int32 Slot = OpenList[Position];
+	const float Key = Nodes[Slot].Key;
+	const int32 Num = OpenList.Num();
+
+	while (true) {
+		int32 Child = Position * 2 + 1;
+		if (Child >= Num) {
+			break;
+		}
+		if (Child + 1 < Num && Nodes[OpenList[Child + 1]].Key < Nodes[OpenList[Child]].Key) {
+			Child++;
+		}
+		if (Nodes[OpenList[Child]].Key >= Key) {
+			break;
+		}
+		OpenList[Position] = OpenList[Child];
+		Nodes[OpenList[Position]].HeapIndex = Position;
+		Position = Child;
+	}
+
+	OpenList[Position] = Slot;
+	Nodes[Slot].HeapIndex = Position;
+}
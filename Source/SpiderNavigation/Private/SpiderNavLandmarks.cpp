@@ -0,0 +1,171 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavLandmarks.h"
+#include "SpiderNavigationModule.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavSearchContext.h"
+
+/** Runs Dijkstra from source node, writes costs of paths to OutDistances or -1 for unreachable nodes. Returns the farthest reached node */
+static int32 ComputeDistances(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 SourceIndex, float* OutDistances)
+{
+	const int32 NodesNum = NavGraph.Num();
+	for (int32 i = 0; i != NodesNum; ++i) {
+		OutDistances[i] = -1.0f;
+	}
+
+	Context.Reset(NodesNum);
+	Context.GetNode(SourceIndex).bOpened = true;
+	Context.PushOpenNode(SourceIndex);
+
+	int32 FarthestIndex = SourceIndex;
+	while (Context.HasOpenNodes()) {
+		const int32 NodeIndex = Context.PopOpenNode();
+		FSpiderNavSearchNode& SearchNode = Context.GetNode(NodeIndex);
+		SearchNode.bClosed = true;
+		OutDistances[NodeIndex] = SearchNode.G;
+		// nodes are closed in order of distance, so the last one is the farthest
+		FarthestIndex = NodeIndex;
+
+		const int32 EdgesEnd = NavGraph.GetEdgesEnd(NodeIndex);
+		for (int32 Edge = NavGraph.GetEdgesBegin(NodeIndex); Edge != EdgesEnd; ++Edge) {
+			const int32 NeighborIndex = NavGraph.EdgeTargets[Edge];
+			FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+
+			if (SearchNeighbor.bClosed) {
+				continue;
+			}
+
+			const float NewG = SearchNode.G + NavGraph.EdgeCosts[Edge];
+			if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+				SearchNeighbor.G = NewG;
+				SearchNeighbor.F = NewG;
+				SearchNeighbor.ParentIndex = NodeIndex;
+
+				if (!SearchNeighbor.bOpened) {
+					SearchNeighbor.bOpened = true;
+					Context.PushOpenNode(NeighborIndex);
+				} else {
+					Context.DecreaseOpenNode(NeighborIndex);
+				}
+			}
+		}
+	}
+
+	return FarthestIndex;
+}
+
+FSpiderNavLandmarks::FSpiderNavLandmarks()
+{
+	LandmarksNum = 0;
+	QuantStep = 1.0f;
+}
+
+void FSpiderNavLandmarks::Build(const FSpiderNavGraph& NavGraph, int32 InLandmarksNum)
+{
+	Empty();
+
+	const int32 NodesNum = NavGraph.Num();
+	if (NodesNum == 0 || InLandmarksNum <= 0) {
+		return;
+	}
+
+	const int32 NewLandmarksNum = FMath::Min(InLandmarksNum, NodesNum);
+	FSpiderNavSearchContext Context;
+
+	// exact distances of landmark i are in range [i * NodesNum, (i + 1) * NodesNum) until they are quantized
+	TArray<float> LandmarkDistances;
+	LandmarkDistances.SetNumUninitialized(NewLandmarksNum * NodesNum);
+
+	// the first landmark is the farthest node from an arbitrary one
+	int32 NextLandmark = ComputeDistances(NavGraph, Context, 0, LandmarkDistances.GetData());
+
+	// the next landmarks are the farthest nodes from already chosen ones. Nodes of other components are infinitely far
+	TArray<float> ClosestLandmarkDistances;
+	ClosestLandmarkDistances.Init(MAX_flt, NodesNum);
+	float MaxDistance = 0.0f;
+
+	for (int32 i = 0; i != NewLandmarksNum; ++i) {
+		LandmarkNodes.Add(NextLandmark);
+		float* Row = &LandmarkDistances[i * NodesNum];
+		ComputeDistances(NavGraph, Context, NextLandmark, Row);
+
+		NextLandmark = INDEX_NONE;
+		float NextLandmarkDistance = -1.0f;
+		for (int32 Node = 0; Node != NodesNum; ++Node) {
+			if (Row[Node] >= 0.0f) {
+				MaxDistance = FMath::Max(MaxDistance, Row[Node]);
+				ClosestLandmarkDistances[Node] = FMath::Min(ClosestLandmarkDistances[Node], Row[Node]);
+			}
+			if (ClosestLandmarkDistances[Node] > NextLandmarkDistance) {
+				NextLandmarkDistance = ClosestLandmarkDistances[Node];
+				NextLandmark = Node;
+			}
+		}
+	}
+
+	LandmarksNum = NewLandmarksNum;
+	QuantStep = MaxDistance > 0.0f ? MaxDistance / (UnreachableDistance - 1) : 1.0f;
+	const float InvQuantStep = 1.0f / QuantStep;
+
+	Distances.SetNumUninitialized(NodesNum * LandmarksNum);
+	for (int32 Landmark = 0; Landmark != LandmarksNum; ++Landmark) {
+		const float* Row = &LandmarkDistances[Landmark * NodesNum];
+		for (int32 Node = 0; Node != NodesNum; ++Node) {
+			Distances[Node * LandmarksNum + Landmark] = Row[Node] < 0.0f
+				? UnreachableDistance
+				: (uint16)FMath::Min(FMath::RoundToInt(Row[Node] * InvQuantStep), UnreachableDistance - 1);
+		}
+	}
+}
+
+void FSpiderNavLandmarks::CopyNodes(const FSpiderNavLandmarks& Source, int32 SourceFirstNode, int32 FirstNode, int32 NodesNum)
+{
+	if (Source.IsEmpty()) {
+		return;
+	}
+
+	check(IsEmpty() || (LandmarksNum == Source.LandmarksNum && QuantStep == Source.QuantStep));
+	LandmarksNum = Source.LandmarksNum;
+	QuantStep = Source.QuantStep;
+	if (Distances.Num() < (FirstNode + NodesNum) * LandmarksNum) {
+		SetNodesNum(FirstNode + NodesNum);
+	}
+	FMemory::Memcpy(Distances.GetData() + FirstNode * LandmarksNum, Source.Distances.GetData() + SourceFirstNode * LandmarksNum, NodesNum * LandmarksNum * sizeof(uint16));
+}
+
+void FSpiderNavLandmarks::SetNodesNum(int32 NodesNum)
+{
+	const int32 OldDistancesNum = Distances.Num();
+	Distances.SetNumUninitialized(NodesNum * LandmarksNum, false);
+	for (int32 i = OldDistancesNum; i < Distances.Num(); ++i) {
+		Distances[i] = UnreachableDistance;
+	}
+}
+
+void FSpiderNavLandmarks::Empty()
+{
+	LandmarkNodes.Empty();
+	Distances.Empty();
+	LandmarksNum = 0;
+	QuantStep = 1.0f;
+}
@@ -0,0 +1,222 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavPathCache.h"
+#include "SpiderNavigationModule.h"
+#include "Misc/ScopeLock.h"
+
+FSpiderNavPathCache::FSpiderNavPathCache()
+{
+	Capacity = 0;
+	GraphId = 0;
+	Newest = INDEX_NONE;
+	Oldest = INDEX_NONE;
+	HitsNum = 0;
+	MissesNum = 0;
+}
+
+void FSpiderNavPathCache::SetCapacity(int32 InCapacity)
+{
+	FScopeLock ScopeLock(&Lock);
+	InCapacity = FMath::Max(InCapacity, 0);
+	if (InCapacity < Entries.Num()) {
+		Clear();
+	}
+	if (InCapacity != Capacity) {
+		// memory for all entries is allocated at once, so adding of path on miss does not allocate once entries are reused
+		Entries.Reserve(InCapacity);
+		EntriesByKey.Reserve(InCapacity);
+		CompleteEntriesByEndNode.Reserve(InCapacity);
+	}
+	Capacity = InCapacity;
+}
+
+void FSpiderNavPathCache::Invalidate(uint32 InGraphId)
+{
+	FScopeLock ScopeLock(&Lock);
+	Clear();
+	GraphId = InGraphId;
+	HitsNum = 0;
+	MissesNum = 0;
+}
+
+void FSpiderNavPathCache::Rebase(uint32 OldGraphId, uint32 NewGraphId, TFunctionRef<bool(int32)> IsNodeKept)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (GraphId != OldGraphId) {
+		Clear();
+		GraphId = NewGraphId;
+		return;
+	}
+
+	GraphId = NewGraphId;
+	TArray<FEntry> OldEntries = MoveTemp(Entries);
+	const int32 OldOldest = Oldest;
+	Clear();
+	Entries.Reserve(Capacity);
+
+	// kept entries are linked again from the oldest one
+	for (int32 OldEntry = OldOldest; OldEntry != INDEX_NONE; OldEntry = OldEntries[OldEntry].Newer) {
+		FEntry& Kept = OldEntries[OldEntry];
+		if (!Kept.bFoundCompletePath || Kept.Path.ContainsByPredicate([&IsNodeKept](int32 Node) { return !IsNodeKept(Node); })) {
+			continue;
+		}
+
+		const int32 Entry = Entries.AddDefaulted();
+		Entries[Entry].StartIndex = Kept.StartIndex;
+		Entries[Entry].EndIndex = Kept.EndIndex;
+		Entries[Entry].Path = MoveTemp(Kept.Path);
+		Entries[Entry].bFoundCompletePath = true;
+		LinkAsNewest(Entry);
+		EntriesByKey.Add(MakeKey(Kept.StartIndex, Kept.EndIndex), Entry);
+		CompleteEntriesByEndNode.Add(Kept.EndIndex, Entry);
+	}
+}
+
+bool FSpiderNavPathCache::Find(uint32 InGraphId, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bOutFoundCompletePath)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (Capacity == 0 || InGraphId != GraphId) {
+		return false;
+	}
+
+	if (int32* Entry = EntriesByKey.Find(MakeKey(StartIndex, EndIndex))) {
+		OutPath.Reset();
+		OutPath.Append(Entries[*Entry].Path);
+		bOutFoundCompletePath = Entries[*Entry].bFoundCompletePath;
+		Touch(*Entry);
+		HitsNum++;
+		return true;
+	}
+
+	for (auto It = CompleteEntriesByEndNode.CreateConstKeyIterator(EndIndex); It; ++It) {
+		const FEntry& CachedEntry = Entries[It.Value()];
+		int32 SuffixStart = CachedEntry.Path.Find(StartIndex);
+		if (SuffixStart != INDEX_NONE) {
+			OutPath.Reset();
+			OutPath.Append(CachedEntry.Path.GetData() + SuffixStart, CachedEntry.Path.Num() - SuffixStart);
+			bOutFoundCompletePath = true;
+			Touch(It.Value());
+			HitsNum++;
+			return true;
+		}
+	}
+
+	MissesNum++;
+	return false;
+}
+
+void FSpiderNavPathCache::Add(uint32 InGraphId, int32 StartIndex, int32 EndIndex, const TArray<int32>& Path, bool bFoundCompletePath)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (Capacity == 0 || InGraphId != GraphId) {
+		return;
+	}
+
+	const uint64 Key = MakeKey(StartIndex, EndIndex);
+	if (int32* Existing = EntriesByKey.Find(Key)) {
+		Touch(*Existing);
+		return;
+	}
+
+	int32 Entry;
+	if (Entries.Num() < Capacity) {
+		Entry = Entries.AddDefaulted();
+		LinkAsNewest(Entry);
+	} else {
+		// reuse the least recently used entry together with memory of its path
+		Entry = Oldest;
+		FEntry& Evicted = Entries[Entry];
+		EntriesByKey.Remove(MakeKey(Evicted.StartIndex, Evicted.EndIndex));
+		if (Evicted.bFoundCompletePath) {
+			CompleteEntriesByEndNode.RemoveSingle(Evicted.EndIndex, Entry);
+		}
+		Touch(Entry);
+	}
+
+	FEntry& NewEntry = Entries[Entry];
+	NewEntry.StartIndex = StartIndex;
+	NewEntry.EndIndex = EndIndex;
+	NewEntry.Path.Reset();
+	NewEntry.Path.Append(Path);
+	NewEntry.bFoundCompletePath = bFoundCompletePath;
+	EntriesByKey.Add(Key, Entry);
+	if (bFoundCompletePath) {
+		CompleteEntriesByEndNode.Add(EndIndex, Entry);
+	}
+}
+
+void FSpiderNavPathCache::GetStats(int32& OutHitsNum, int32& OutMissesNum, int32& OutPathsNum)
+{
+	FScopeLock ScopeLock(&Lock);
+	OutHitsNum = HitsNum;
+	OutMissesNum = MissesNum;
+	OutPathsNum = Entries.Num();
+}
+
+void FSpiderNavPathCache::Touch(int32 Entry)
+{
+	if (Entry != Newest) {
+		Unlink(Entry);
+		LinkAsNewest(Entry);
+	}
+}
+
+void FSpiderNavPathCache::Unlink(int32 Entry)
+{
+	FEntry& Linked = Entries[Entry];
+	if (Linked.Newer != INDEX_NONE) {
+		Entries[Linked.Newer].Older = Linked.Older;
+	} else {
+		Newest = Linked.Older;
+	}
+	if (Linked.Older != INDEX_NONE) {
+		Entries[Linked.Older].Newer = Linked.Newer;
+	} else {
+		Oldest = Linked.Newer;
+	}
+	Linked.Newer = INDEX_NONE;
+	Linked.Older = INDEX_NONE;
+}
+
+void FSpiderNavPathCache::LinkAsNewest(int32 Entry)
+{
+	FEntry& Linked = Entries[Entry];
+	Linked.Newer = INDEX_NONE;
+	Linked.Older = Newest;
+	if (Newest != INDEX_NONE) {
+		Entries[Newest].Newer = Entry;
+	}
+	Newest = Entry;
+	if (Oldest == INDEX_NONE) {
+		Oldest = Entry;
+	}
+}
+
+void FSpiderNavPathCache::Clear()
+{
+	Entries.Reset();
+	EntriesByKey.Reset();
+	CompleteEntriesByEndNode.Reset();
+	Newest = INDEX_NONE;
+	Oldest = INDEX_NONE;
+}
@@ -0,0 +1,160 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavSearchContext.h"
+#include "SpiderNavigationModule.h"
+#include "Misc/ScopeLock.h"
+
+/** Number of children of each node in open list */
+static const int32 OpenListArity = 4;
+
+FSpiderNavSearchContext::FSpiderNavSearchContext()
+{
+	ExpandedNodesNum = 0;
+	Generation = 0;
+}
+
+void FSpiderNavSearchContext::Reset(int32 NodesNum)
+{
+	OpenList.Reset();
+	ExpandedNodesNum = 0;
+
+	if (Nodes.Num() != NodesNum) {
+		Nodes.Reset();
+		Nodes.SetNumZeroed(NodesNum);
+		Generation = 0;
+	}
+
+	Generation++;
+	if (Generation == 0) {
+		// generations have been overflowed, so old stamps could be taken as actual
+		for (FSpiderNavSearchNode& Node : Nodes) {
+			Node.Generation = 0;
+		}
+		Generation = 1;
+	}
+}
+
+void FSpiderNavSearchContext::PushOpenNode(int32 Index)
+{
+	int32 Position = OpenList.Add(Index);
+	Nodes[Index].HeapIndex = Position;
+	SiftUp(Position);
+}
+
+void FSpiderNavSearchContext::DecreaseOpenNode(int32 Index)
+{
+	SiftUp(Nodes[Index].HeapIndex);
+}
+
+int32 FSpiderNavSearchContext::PopOpenNode()
+{
+	int32 Top = OpenList[0];
+	int32 Last = OpenList.Pop(false);
+	if (OpenList.Num()) {
+		OpenList[0] = Last;
+		SiftDown(0);
+	}
+	Nodes[Top].HeapIndex = INDEX_NONE;
+	ExpandedNodesNum++;
+
+	return Top;
+}
+
+void FSpiderNavSearchContext::SiftUp(int32 Position)
+{
+	const int32 Index = OpenList[Position];
+	const float F = Nodes[Index].F;
+
+	while (Position > 0) {
+		int32 ParentPosition = (Position - 1) / OpenListArity;
+		int32 ParentIndex = OpenList[ParentPosition];
+		if (Nodes[ParentIndex].F <= F) {
+			break;
+		}
+		OpenList[Position] = ParentIndex;
+		Nodes[ParentIndex].HeapIndex = Position;
+		Position = ParentPosition;
+	}
+
+	OpenList[Position] = Index;
+	Nodes[Index].HeapIndex = Position;
+}
+
+void FSpiderNavSearchContext::SiftDown(int32 Position)
+{
+	const int32 Index = OpenList[Position];
+	const float F = Nodes[Index].F;
+	const int32 Num = OpenList.Num();
+
+	while (true) {
+		int32 FirstChild = Position * OpenListArity + 1;
+		if (FirstChild >= Num) {
+			break;
+		}
+
+		// find the child with the lowest F-value
+		int32 LastChild = FMath::Min(FirstChild + OpenListArity, Num);
+		int32 BestChild = FirstChild;
+		float BestF = Nodes[OpenList[FirstChild]].F;
+		for (int32 Child = FirstChild + 1; Child < LastChild; ++Child) {
+			float ChildF = Nodes[OpenList[Child]].F;
+			if (ChildF < BestF) {
+				BestF = ChildF;
+				BestChild = Child;
+			}
+		}
+
+		if (BestF >= F) {
+			break;
+		}
+		OpenList[Position] = OpenList[BestChild];
+		Nodes[OpenList[Position]].HeapIndex = Position;
+		Position = BestChild;
+	}
+
+	OpenList[Position] = Index;
+	Nodes[Index].HeapIndex = Position;
+}
+
+TUniquePtr<FSpiderNavSearchContext> FSpiderNavSearchContextPool::Acquire()
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (FreeContexts.Num()) {
+			return FreeContexts.Pop(false);
+		}
+	}
+	return MakeUnique<FSpiderNavSearchContext>();
+}
+
+void FSpiderNavSearchContextPool::Release(TUniquePtr<FSpiderNavSearchContext> Context)
+{
+	FScopeLock ScopeLock(&Lock);
+	FreeContexts.Add(MoveTemp(Context));
+}
+
+void FSpiderNavSearchContextPool::Empty()
+{
+	FScopeLock ScopeLock(&Lock);
+	FreeContexts.Empty();
+}
@@ -0,0 +1,515 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavSpatialIndex.h"
+#include "SpiderNavigationModule.h"
+
+FSpiderNavSpatialIndex::FSpiderNavSpatialIndex()
+{
+	CellSize = 100.0f;
+	InvCellSize = 1.0f / CellSize;
+	OffsetStep = CellSize / MAX_uint16;
+	InvOffsetStep = MAX_uint16 / CellSize;
+	MinCoord = FIntVector::ZeroValue;
+	MaxCoord = FIntVector::ZeroValue;
+}
+
+void FSpiderNavSpatialIndex::Build(const TArray<FVector>& Locations, float InCellSize)
+{
+	Init(InCellSize);
+
+	if (Locations.Num() == 0) {
+		return;
+	}
+
+	// count nodes in each cell
+	TArray<FIntVector> NodesCoords;
+	NodesCoords.SetNumUninitialized(Locations.Num());
+	MinCoord = GetCellCoord(Locations[0]);
+	MaxCoord = MinCoord;
+	for (int32 i = 0; i != Locations.Num(); ++i) {
+		FIntVector Coord = GetCellCoord(Locations[i]);
+		NodesCoords[i] = Coord;
+		AddToBounds(Coord);
+
+		Cells.FindOrAdd(Coord).Num++;
+	}
+
+	// assign contiguous ranges to cells
+	int32 First = 0;
+	for (auto It = Cells.CreateIterator(); It; ++It) {
+		It.Value().First = First;
+		First += It.Value().Num;
+		It.Value().Num = 0;
+	}
+
+	SortedNodes.SetNumUninitialized(Locations.Num());
+	SortedX.SetNumUninitialized(Locations.Num());
+	SortedY.SetNumUninitialized(Locations.Num());
+	SortedZ.SetNumUninitialized(Locations.Num());
+	for (int32 i = 0; i != Locations.Num(); ++i) {
+		FCell& Cell = Cells.FindChecked(NodesCoords[i]);
+		SetSlot(Cell.First + Cell.Num, i, Locations[i], NodesCoords[i]);
+		Cell.Num++;
+	}
+}
+
+void FSpiderNavSpatialIndex::Init(float InCellSize)
+{
+	Empty();
+
+	CellSize = FMath::Max(InCellSize, KINDA_SMALL_NUMBER);
+	InvCellSize = 1.0f / CellSize;
+	OffsetStep = CellSize / MAX_uint16;
+	InvOffsetStep = MAX_uint16 / CellSize;
+}
+
+void FSpiderNavSpatialIndex::CopyFrom(const FSpiderNavSpatialIndex& Source, TFunctionRef<bool(int32)> Filter)
+{
+	Init(Source.CellSize);
+
+	Cells.Reserve(Source.Cells.Num());
+	SortedNodes.Reserve(Source.SortedNodes.Num());
+	SortedX.Reserve(Source.SortedNodes.Num());
+	SortedY.Reserve(Source.SortedNodes.Num());
+	SortedZ.Reserve(Source.SortedNodes.Num());
+	for (auto It = Source.Cells.CreateConstIterator(); It; ++It) {
+		FCell Cell;
+		Cell.First = SortedNodes.Num();
+		for (int32 Slot = It.Value().First; Slot != It.Value().First + It.Value().Num; ++Slot) {
+			if (Filter(Source.SortedNodes[Slot])) {
+				SortedNodes.Add(Source.SortedNodes[Slot]);
+				SortedX.Add(Source.SortedX[Slot]);
+				SortedY.Add(Source.SortedY[Slot]);
+				SortedZ.Add(Source.SortedZ[Slot]);
+			}
+		}
+
+		Cell.Num = SortedNodes.Num() - Cell.First;
+		if (Cell.Num > 0) {
+			if (Cells.Num() == 0) {
+				MinCoord = It.Key();
+				MaxCoord = It.Key();
+			}
+			AddToBounds(It.Key());
+			Cells.Add(It.Key(), Cell);
+		}
+	}
+}
+
+void FSpiderNavSpatialIndex::AddNodes(const TArray<FVector>& Locations, int32 FirstNode)
+{
+	if (Locations.Num() == 0) {
+		return;
+	}
+
+	// count new nodes in each cell
+	TArray<FIntVector> NodesCoords;
+	NodesCoords.SetNumUninitialized(Locations.Num());
+	TMap<FIntVector, FCell> NewCells;
+	for (int32 i = 0; i != Locations.Num(); ++i) {
+		NodesCoords[i] = GetCellCoord(Locations[i]);
+		NewCells.FindOrAdd(NodesCoords[i]).Num++;
+	}
+
+	// nodes of cell have to be contiguous, so nodes which are already in cell are moved after all slots together with new ones
+	int32 SlotsNum = SortedNodes.Num();
+	for (auto It = NewCells.CreateIterator(); It; ++It) {
+		const FCell* OldCell = Cells.Find(It.Key());
+		It.Value().First = SlotsNum;
+		SlotsNum += It.Value().Num + (OldCell ? OldCell->Num : 0);
+		It.Value().Num = 0;
+	}
+
+	SortedNodes.SetNumUninitialized(SlotsNum, false);
+	SortedX.SetNumUninitialized(SlotsNum, false);
+	SortedY.SetNumUninitialized(SlotsNum, false);
+	SortedZ.SetNumUninitialized(SlotsNum, false);
+	for (auto It = NewCells.CreateIterator(); It; ++It) {
+		FCell& Cell = It.Value();
+		if (const FCell* OldCell = Cells.Find(It.Key())) {
+			for (int32 i = 0; i != OldCell->Num; ++i) {
+				SortedNodes[Cell.First + i] = SortedNodes[OldCell->First + i];
+				SortedX[Cell.First + i] = SortedX[OldCell->First + i];
+				SortedY[Cell.First + i] = SortedY[OldCell->First + i];
+				SortedZ[Cell.First + i] = SortedZ[OldCell->First + i];
+			}
+			Cell.Num = OldCell->Num;
+		}
+	}
+
+	if (Cells.Num() == 0) {
+		MinCoord = NodesCoords[0];
+		MaxCoord = NodesCoords[0];
+	}
+	for (int32 i = 0; i != Locations.Num(); ++i) {
+		FCell& Cell = NewCells.FindChecked(NodesCoords[i]);
+		SetSlot(Cell.First + Cell.Num, FirstNode + i, Locations[i], NodesCoords[i]);
+		Cell.Num++;
+	}
+
+	for (auto It = NewCells.CreateConstIterator(); It; ++It) {
+		AddToBounds(It.Key());
+		Cells.Add(It.Key(), It.Value());
+	}
+}
+
+void FSpiderNavSpatialIndex::AddToBounds(const FIntVector& Coord)
+{
+	MinCoord = FIntVector(FMath::Min(MinCoord.X, Coord.X), FMath::Min(MinCoord.Y, Coord.Y), FMath::Min(MinCoord.Z, Coord.Z));
+	MaxCoord = FIntVector(FMath::Max(MaxCoord.X, Coord.X), FMath::Max(MaxCoord.Y, Coord.Y), FMath::Max(MaxCoord.Z, Coord.Z));
+}
+
+void FSpiderNavSpatialIndex::SetSlot(int32 Slot, int32 Node, const FVector& Location, const FIntVector& Coord)
+{
+	SortedNodes[Slot] = Node;
+
+	// node lies inside of its cell, so offset is rounded to one of 65536 steps along cell's edge
+	const FVector Offset = (Location - GetCellOrigin(Coord)) / OffsetStep;
+	SortedX[Slot] = (uint16)FMath::Clamp(FMath::RoundToInt(Offset.X), 0, (int32)MAX_uint16);
+	SortedY[Slot] = (uint16)FMath::Clamp(FMath::RoundToInt(Offset.Y), 0, (int32)MAX_uint16);
+	SortedZ[Slot] = (uint16)FMath::Clamp(FMath::RoundToInt(Offset.Z), 0, (int32)MAX_uint16);
+}
+
+void FSpiderNavSpatialIndex::Empty()
+{
+	Cells.Empty();
+	SortedNodes.Empty();
+	SortedX.Empty();
+	SortedY.Empty();
+	SortedZ.Empty();
+	MinCoord = FIntVector::ZeroValue;
+	MaxCoord = FIntVector::ZeroValue;
+}
+
+template <typename VisitorType>
+void FSpiderNavSpatialIndex::ForEachCellInRing(const FIntVector& Center, int32 Ring, VisitorType Visitor) const
+{
+	const int32 StartX = FMath::Max(Center.X - Ring, MinCoord.X);
+	const int32 EndX = FMath::Min(Center.X + Ring, MaxCoord.X);
+	const int32 StartY = FMath::Max(Center.Y - Ring, MinCoord.Y);
+	const int32 EndY = FMath::Min(Center.Y + Ring, MaxCoord.Y);
+	const int32 StartZ = FMath::Max(Center.Z - Ring, MinCoord.Z);
+	const int32 EndZ = FMath::Min(Center.Z + Ring, MaxCoord.Z);
+
+	for (int32 x = StartX; x <= EndX; x++) {
+		const bool bOnFaceX = FMath::Abs(x - Center.X) == Ring;
+		for (int32 y = StartY; y <= EndY; y++) {
+			const bool bOnFaceXY = bOnFaceX || FMath::Abs(y - Center.Y) == Ring;
+			if (bOnFaceXY) {
+				for (int32 z = StartZ; z <= EndZ; z++) {
+					const FIntVector Coord(x, y, z);
+					if (const FCell* Cell = Cells.Find(Coord)) {
+						Visitor(*Cell, Coord);
+					}
+				}
+			} else {
+				// inside of the shell only the top and the bottom cells belong to the ring
+				if (Center.Z - Ring >= MinCoord.Z) {
+					const FIntVector Coord(x, y, Center.Z - Ring);
+					if (const FCell* Cell = Cells.Find(Coord)) {
+						Visitor(*Cell, Coord);
+					}
+				}
+				if (Center.Z + Ring <= MaxCoord.Z) {
+					const FIntVector Coord(x, y, Center.Z + Ring);
+					if (const FCell* Cell = Cells.Find(Coord)) {
+						Visitor(*Cell, Coord);
+					}
+				}
+			}
+		}
+	}
+}
+
+template <typename FilterType>
+void FSpiderNavSpatialIndex::ScanSlots(int32 First, int32 Last, const FVector& LocalOffsets, FilterType& Filter, int32& BestSlot, float& BestDistanceSquared) const
+{
+	const VectorRegister LocationX = VectorLoadFloat1(&LocalOffsets.X);
+	const VectorRegister LocationY = VectorLoadFloat1(&LocalOffsets.Y);
+	const VectorRegister LocationZ = VectorLoadFloat1(&LocalOffsets.Z);
+
+	int32 Slot = First;
+	for (; Slot + 4 <= Last; Slot += 4) {
+		const VectorRegister DX = VectorSubtract(LoadOffsets(SortedX, Slot), LocationX);
+		const VectorRegister DY = VectorSubtract(LoadOffsets(SortedY, Slot), LocationY);
+		const VectorRegister DZ = VectorSubtract(LoadOffsets(SortedZ, Slot), LocationZ);
+		const VectorRegister DistancesSquared = VectorMultiplyAdd(DZ, DZ, VectorMultiplyAdd(DY, DY, VectorMultiply(DX, DX)));
+
+		// most groups of four nodes are farther than the best one, they are rejected by one comparison
+		if (!VectorAnyGreaterThan(VectorLoadFloat1(&BestDistanceSquared), DistancesSquared)) {
+			continue;
+		}
+
+		float Lanes[4];
+		VectorStore(DistancesSquared, Lanes);
+		for (int32 Lane = 0; Lane < 4; Lane++) {
+			if (Lanes[Lane] < BestDistanceSquared && Filter(SortedNodes[Slot + Lane])) {
+				BestDistanceSquared = Lanes[Lane];
+				BestSlot = Slot + Lane;
+			}
+		}
+	}
+
+	for (; Slot < Last; Slot++) {
+		const float DistanceSquared = FMath::Square(SortedX[Slot] - LocalOffsets.X) + FMath::Square(SortedY[Slot] - LocalOffsets.Y) + FMath::Square(SortedZ[Slot] - LocalOffsets.Z);
+		if (DistanceSquared < BestDistanceSquared && Filter(SortedNodes[Slot])) {
+			BestDistanceSquared = DistanceSquared;
+			BestSlot = Slot;
+		}
+	}
+}
+
+void FSpiderNavSpatialIndex::ScanSlotsForLocations(int32 First, int32 Last, const FVector* LocalOffsets, int32 LocationsNum, int32* BestSlots, float* BestDistancesSquared) const
+{
+	int32 Slot = First;
+	for (; Slot + 4 <= Last; Slot += 4) {
+		const VectorRegister X = LoadOffsets(SortedX, Slot);
+		const VectorRegister Y = LoadOffsets(SortedY, Slot);
+		const VectorRegister Z = LoadOffsets(SortedZ, Slot);
+
+		for (int32 i = 0; i != LocationsNum; ++i) {
+			const VectorRegister DX = VectorSubtract(X, VectorLoadFloat1(&LocalOffsets[i].X));
+			const VectorRegister DY = VectorSubtract(Y, VectorLoadFloat1(&LocalOffsets[i].Y));
+			const VectorRegister DZ = VectorSubtract(Z, VectorLoadFloat1(&LocalOffsets[i].Z));
+			const VectorRegister DistancesSquared = VectorMultiplyAdd(DZ, DZ, VectorMultiplyAdd(DY, DY, VectorMultiply(DX, DX)));
+
+			if (!VectorAnyGreaterThan(VectorLoadFloat1(&BestDistancesSquared[i]), DistancesSquared)) {
+				continue;
+			}
+
+			float Lanes[4];
+			VectorStore(DistancesSquared, Lanes);
+			for (int32 Lane = 0; Lane < 4; Lane++) {
+				if (Lanes[Lane] < BestDistancesSquared[i]) {
+					BestDistancesSquared[i] = Lanes[Lane];
+					BestSlots[i] = Slot + Lane;
+				}
+			}
+		}
+	}
+
+	for (; Slot < Last; Slot++) {
+		for (int32 i = 0; i != LocationsNum; ++i) {
+			const float DistanceSquared = FMath::Square(SortedX[Slot] - LocalOffsets[i].X) + FMath::Square(SortedY[Slot] - LocalOffsets[i].Y) + FMath::Square(SortedZ[Slot] - LocalOffsets[i].Z);
+			if (DistanceSquared < BestDistancesSquared[i]) {
+				BestDistancesSquared[i] = DistanceSquared;
+				BestSlots[i] = Slot;
+			}
+		}
+	}
+}
+
+template <typename FilterType>
+int32 FSpiderNavSpatialIndex::FindClosestFiltered(const FVector& Location, FilterType Filter) const
+{
+	if (SortedNodes.Num() == 0) {
+		return INDEX_NONE;
+	}
+
+	const FIntVector Center = GetCellCoord(Location);
+	int32 FirstRing;
+	int32 LastRing;
+	GetRingsRange(Center, FirstRing, LastRing);
+
+	int32 BestSlot = INDEX_NONE;
+	float BestDistanceSquared = MAX_flt;
+
+	// distances are in units of offsets, so offsets of nodes are compared without scaling
+	for (int32 Ring = FirstRing; Ring <= LastRing; ++Ring) {
+		// nodes in this and further rings are not closer than (Ring - 1) cells
+		float MinRingDistance = (Ring - 1) * (float)MAX_uint16;
+		if (BestSlot != INDEX_NONE && MinRingDistance > 0.0f && BestDistanceSquared <= MinRingDistance * MinRingDistance) {
+			break;
+		}
+
+		ForEachCellInRing(Center, Ring, [&](const FCell& Cell, const FIntVector& Coord) {
+			ScanSlots(Cell.First, Cell.First + Cell.Num, GetLocalOffsets(Location, Coord), Filter, BestSlot, BestDistanceSquared);
+		});
+	}
+
+	return BestSlot != INDEX_NONE ? SortedNodes[BestSlot] : INDEX_NONE;
+}
+
+int32 FSpiderNavSpatialIndex::FindClosest(const FVector& Location) const
+{
+	return FindClosestFiltered(Location, [](int32 Node) {
+		return true;
+	});
+}
+
+int32 FSpiderNavSpatialIndex::FindClosest(const FVector& Location, TFunctionRef<bool(int32)> Filter) const
+{
+	return FindClosestFiltered(Location, Filter);
+}
+
+void FSpiderNavSpatialIndex::FindClosest(const TArray<FVector>& Locations, TArray<int32>& OutNodes) const
+{
+	if (SortedNodes.Num() == 0) {
+		OutNodes.Init(INDEX_NONE, Locations.Num());
+		return;
+	}
+	OutNodes.SetNumUninitialized(Locations.Num());
+
+	TArray<TPair<FIntVector, int32>> Queries;
+	Queries.Reserve(Locations.Num());
+	for (int32 i = 0; i != Locations.Num(); ++i) {
+		Queries.Emplace(GetCellCoord(Locations[i]), i);
+	}
+	Queries.Sort([](const TPair<FIntVector, int32>& A, const TPair<FIntVector, int32>& B) {
+		if (A.Key.Z != B.Key.Z) {
+			return A.Key.Z < B.Key.Z;
+		}
+		if (A.Key.Y != B.Key.Y) {
+			return A.Key.Y < B.Key.Y;
+		}
+		return A.Key.X < B.Key.X;
+	});
+
+	TArray<FVector> SortedLocations;
+	TArray<FVector> LocalOffsets;
+	TArray<int32> BestSlots;
+	TArray<float> BestDistancesSquared;
+	SortedLocations.SetNumUninitialized(Queries.Num());
+	LocalOffsets.SetNumUninitialized(Queries.Num());
+	BestSlots.Init(INDEX_NONE, Queries.Num());
+	BestDistancesSquared.Init(MAX_flt, Queries.Num());
+	for (int32 i = 0; i != Queries.Num(); ++i) {
+		SortedLocations[i] = Locations[Queries[i].Value];
+	}
+
+	// locations of one cell have the same rings around them, so they are searched as one group
+	for (int32 GroupFirst = 0; GroupFirst != Queries.Num();) {
+		const FIntVector Center = Queries[GroupFirst].Key;
+		int32 GroupLast = GroupFirst + 1;
+		while (GroupLast != Queries.Num() && Queries[GroupLast].Key == Center) {
+			GroupLast++;
+		}
+		const int32 GroupNum = GroupLast - GroupFirst;
+
+		int32 FirstRing;
+		int32 LastRing;
+		GetRingsRange(Center, FirstRing, LastRing);
+
+		for (int32 Ring = FirstRing; Ring <= LastRing; ++Ring) {
+			// the group is finished when no location of it can find a closer node in the further rings. Distances are in units of offsets
+			const float MinRingDistance = (Ring - 1) * (float)MAX_uint16;
+			if (MinRingDistance > 0.0f) {
+				bool bAllFound = true;
+				for (int32 i = GroupFirst; i != GroupLast && bAllFound; ++i) {
+					bAllFound = BestSlots[i] != INDEX_NONE && BestDistancesSquared[i] <= MinRingDistance * MinRingDistance;
+				}
+				if (bAllFound) {
+					break;
+				}
+			}
+
+			ForEachCellInRing(Center, Ring, [&](const FCell& Cell, const FIntVector& Coord) {
+				for (int32 i = GroupFirst; i != GroupLast; ++i) {
+					LocalOffsets[i] = GetLocalOffsets(SortedLocations[i], Coord);
+				}
+				ScanSlotsForLocations(Cell.First, Cell.First + Cell.Num, &LocalOffsets[GroupFirst], GroupNum, &BestSlots[GroupFirst], &BestDistancesSquared[GroupFirst]);
+			});
+		}
+
+		GroupFirst = GroupLast;
+	}
+
+	for (int32 i = 0; i != Queries.Num(); ++i) {
+		OutNodes[Queries[i].Value] = BestSlots[i] != INDEX_NONE ? SortedNodes[BestSlots[i]] : INDEX_NONE;
+	}
+}
+
+void FSpiderNavSpatialIndex::FindClosest(const FVector& Location, int32 Count, TArray<int32>& OutNodes) const
+{
+	OutNodes.Reset();
+	if (SortedNodes.Num() == 0 || Count <= 0) {
+		return;
+	}
+
+	// max-heap of found candidates, the farthest one is on top
+	typedef TPair<float, int32> FCandidate;
+	struct FFartherFirst
+	{
+		bool operator()(const FCandidate& A, const FCandidate& B) const
+		{
+			return A.Key > B.Key;
+		}
+	};
+	TArray<FCandidate, TInlineAllocator<16>> Candidates;
+
+	const FIntVector Center = GetCellCoord(Location);
+	int32 FirstRing;
+	int32 LastRing;
+	GetRingsRange(Center, FirstRing, LastRing);
+
+	for (int32 Ring = FirstRing; Ring <= LastRing; ++Ring) {
+		float MinRingDistance = (Ring - 1) * CellSize;
+		if (Candidates.Num() == Count && MinRingDistance > 0.0f && Candidates.HeapTop().Key <= MinRingDistance * MinRingDistance) {
+			break;
+		}
+
+		ForEachCellInRing(Center, Ring, [&](const FCell& Cell, const FIntVector& Coord) {
+			const FVector LocalLocation = Location - GetCellOrigin(Coord);
+			for (int32 Slot = Cell.First; Slot != Cell.First + Cell.Num; ++Slot) {
+				float DistanceSquared = FMath::Square(GetOffset(SortedX, Slot) - LocalLocation.X) + FMath::Square(GetOffset(SortedY, Slot) - LocalLocation.Y) + FMath::Square(GetOffset(SortedZ, Slot) - LocalLocation.Z);
+				if (Candidates.Num() < Count) {
+					Candidates.HeapPush(FCandidate(DistanceSquared, SortedNodes[Slot]), FFartherFirst());
+				} else if (DistanceSquared < Candidates.HeapTop().Key) {
+					Candidates.HeapPopDiscard(FFartherFirst(), false);
+					Candidates.HeapPush(FCandidate(DistanceSquared, SortedNodes[Slot]), FFartherFirst());
+				}
+			}
+		});
+	}
+
+	Candidates.Sort([](const FCandidate& A, const FCandidate& B) {
+		return A.Key < B.Key;
+	});
+	for (const FCandidate& Candidate : Candidates) {
+		OutNodes.Add(Candidate.Value);
+	}
+}
+
+FIntVector FSpiderNavSpatialIndex::GetCellCoord(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X * InvCellSize),
+		FMath::FloorToInt(Location.Y * InvCellSize),
+		FMath::FloorToInt(Location.Z * InvCellSize)
+	);
+}
+
+void FSpiderNavSpatialIndex::GetRingsRange(const FIntVector& Center, int32& OutFirstRing, int32& OutLastRing) const
+{
+	// distance in cells from center to the box of occupied cells
+	int32 OutsideX = FMath::Max3(MinCoord.X - Center.X, 0, Center.X - MaxCoord.X);
+	int32 OutsideY = FMath::Max3(MinCoord.Y - Center.Y, 0, Center.Y - MaxCoord.Y);
+	int32 OutsideZ = FMath::Max3(MinCoord.Z - Center.Z, 0, Center.Z - MaxCoord.Z);
+	OutFirstRing = FMath::Max3(OutsideX, OutsideY, OutsideZ);
+
+	// distance in cells from center to the farthest corner of the box
+	int32 FarX = FMath::Max(FMath::Abs(Center.X - MinCoord.X), FMath::Abs(Center.X - MaxCoord.X));
+	int32 FarY = FMath::Max(FMath::Abs(Center.Y - MinCoord.Y), FMath::Abs(Center.Y - MaxCoord.Y));
+	int32 FarZ = FMath::Max(FMath::Abs(Center.Z - MinCoord.Z), FMath::Abs(Center.Z - MaxCoord.Z));
+	OutLastRing = FMath::Max3(FarX, FarY, FarZ);
+}
@@ -0,0 +1,249 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavTiles.h"
+#include "SpiderNavigationModule.h"
+#include "SpiderNavGraph.h"
+
+FSpiderNavTiles::FSpiderNavTiles()
+{
+	TileSize = 0.0f;
+	QuantizationStep = 0.0f;
+	CellSize = 100.0f;
+}
+
+void FSpiderNavTiles::Build(FSpiderNavGridData&& InGridData, float InTileSize)
+{
+	TileSize = InTileSize;
+	// the largest offset is kept below MAX_uint16, so rounding of it can not overflow
+	QuantizationStep = TileSize / (MAX_uint16 - 1);
+	NodeOffsets.Empty();
+	Locations.Empty();
+	Normals.Empty();
+	EdgeOffsets.Empty();
+	EdgeTargets.Empty();
+	ComponentOffsets.Empty();
+	NodeComponents.Empty();
+	LinkOffsets.Empty();
+	Links.Empty();
+	TileCoords.Empty();
+	TilesByCoords.Empty();
+	Landmarks.Empty();
+
+	const int32 NodesNum = InGridData.Locations.Num();
+	const int32 EdgesNum = InGridData.EdgeTargets.Num();
+
+	// old saves do not have step of grid, so take average length of edges instead like FSpiderNavGraph does
+	CellSize = InGridData.GridStepSize;
+	if (CellSize <= 0.0f) {
+		float EdgesLength = 0.0f;
+		for (int32 i = 0; i != NodesNum; ++i) {
+			for (int32 Edge = InGridData.EdgeOffsets[i]; Edge != InGridData.EdgeOffsets[i + 1]; ++Edge) {
+				EdgesLength += (InGridData.Locations[InGridData.EdgeTargets[Edge]] - InGridData.Locations[i]).Size();
+			}
+		}
+		CellSize = EdgesNum > 0 ? EdgesLength / EdgesNum : 100.0f;
+	}
+
+	TArray<int32> SourceTiles;
+	SourceTiles.SetNumUninitialized(NodesNum);
+	for (int32 i = 0; i != NodesNum; ++i) {
+		const FIntVector Coords = GetTileCoords(InGridData.Locations[i]);
+		const int32* Tile = TilesByCoords.Find(Coords);
+		SourceTiles[i] = Tile ? *Tile : TilesByCoords.Add(Coords, TileCoords.Add(Coords));
+	}
+
+	// counting sort keeps order of nodes inside each tile
+	NodeOffsets.Init(0, TileCoords.Num() + 1);
+	for (int32 Tile : SourceTiles) {
+		NodeOffsets[Tile + 1]++;
+	}
+	for (int32 Tile = 0; Tile != TileCoords.Num(); ++Tile) {
+		NodeOffsets[Tile + 1] += NodeOffsets[Tile];
+	}
+
+	TArray<int32> NewIndexes;
+	NewIndexes.SetNumUninitialized(NodesNum);
+	TArray<int32> NextNodes = NodeOffsets;
+	for (int32 i = 0; i != NodesNum; ++i) {
+		NewIndexes[i] = NextNodes[SourceTiles[i]]++;
+	}
+
+	TArray<int32> NodeTiles;
+	NodeTiles.SetNumUninitialized(NodesNum);
+	Locations.SetNumUninitialized(NodesNum);
+	Normals.SetNumUninitialized(NodesNum);
+	TArray<int32> EdgesNums;
+	EdgesNums.SetNumUninitialized(NodesNum);
+	for (int32 i = 0; i != NodesNum; ++i) {
+		const int32 NewIndex = NewIndexes[i];
+		const FVector Offset = (InGridData.Locations[i] - GetTileOrigin(SourceTiles[i])) / QuantizationStep;
+		FSpiderNavTileLocation& Location = Locations[NewIndex];
+		Location.X = (uint16)FMath::Clamp(FMath::RoundToInt(Offset.X), 0, (int32)MAX_uint16);
+		Location.Y = (uint16)FMath::Clamp(FMath::RoundToInt(Offset.Y), 0, (int32)MAX_uint16);
+		Location.Z = (uint16)FMath::Clamp(FMath::RoundToInt(Offset.Z), 0, (int32)MAX_uint16);
+		Normals[NewIndex] = FSpiderNavGraph::EncodeNormal(InGridData.Normals[i]);
+		NodeTiles[NewIndex] = SourceTiles[i];
+		EdgesNums[NewIndex] = InGridData.EdgeOffsets[i + 1] - InGridData.EdgeOffsets[i];
+	}
+
+	EdgeOffsets.SetNumUninitialized(NodesNum + 1);
+	EdgeOffsets[0] = 0;
+	for (int32 i = 0; i != NodesNum; ++i) {
+		EdgeOffsets[i + 1] = EdgeOffsets[i] + EdgesNums[i];
+	}
+
+	EdgeTargets.SetNumUninitialized(EdgesNum);
+	for (int32 i = 0; i != NodesNum; ++i) {
+		int32 Edge = EdgeOffsets[NewIndexes[i]];
+		for (int32 SourceEdge = InGridData.EdgeOffsets[i]; SourceEdge != InGridData.EdgeOffsets[i + 1]; ++SourceEdge) {
+			EdgeTargets[Edge++] = NewIndexes[InGridData.EdgeTargets[SourceEdge]];
+		}
+	}
+
+	InGridData.Empty();
+
+	// breadth-first search from each node which has not been labeled yet, but only by edges inside of its tile
+	NodeComponents.Init(INDEX_NONE, NodesNum);
+	ComponentOffsets.SetNumUninitialized(TileCoords.Num() + 1);
+	ComponentOffsets[0] = 0;
+	TArray<int32> Queue;
+	int32 ComponentsNum = 0;
+	for (int32 Tile = 0; Tile != TileCoords.Num(); ++Tile) {
+		for (int32 Root = NodeOffsets[Tile]; Root != NodeOffsets[Tile + 1]; ++Root) {
+			if (NodeComponents[Root] != INDEX_NONE) {
+				continue;
+			}
+
+			const int32 Component = ComponentsNum++;
+			NodeComponents[Root] = Component;
+			Queue.Reset();
+			Queue.Add(Root);
+			for (int32 Queued = 0; Queued < Queue.Num(); ++Queued) {
+				const int32 Node = Queue[Queued];
+				for (int32 Edge = EdgeOffsets[Node]; Edge != EdgeOffsets[Node + 1]; ++Edge) {
+					const int32 Neighbor = EdgeTargets[Edge];
+					if (NodeTiles[Neighbor] == Tile && NodeComponents[Neighbor] == INDEX_NONE) {
+						NodeComponents[Neighbor] = Component;
+						Queue.Add(Neighbor);
+					}
+				}
+			}
+		}
+		ComponentOffsets[Tile + 1] = ComponentsNum;
+	}
+
+	// edges which cross borders of tiles are reduced to unique pairs of components, so components of streamed grid are merged by them
+	LinkOffsets.SetNumUninitialized(TileCoords.Num() + 1);
+	LinkOffsets[0] = 0;
+	for (int32 Tile = 0; Tile != TileCoords.Num(); ++Tile) {
+		const int32 FirstLink = Links.Num();
+		for (int32 Node = NodeOffsets[Tile]; Node != NodeOffsets[Tile + 1]; ++Node) {
+			for (int32 Edge = EdgeOffsets[Node]; Edge != EdgeOffsets[Node + 1]; ++Edge) {
+				const int32 Neighbor = EdgeTargets[Edge];
+				if (NodeTiles[Neighbor] != Tile) {
+					FSpiderNavTileLink Link;
+					Link.Component = NodeComponents[Node];
+					Link.NeighborTile = NodeTiles[Neighbor];
+					Link.NeighborComponent = NodeComponents[Neighbor];
+					Links.Add(Link);
+				}
+			}
+		}
+
+		Sort(Links.GetData() + FirstLink, Links.Num() - FirstLink, [](const FSpiderNavTileLink& A, const FSpiderNavTileLink& B) {
+			return A.Component != B.Component ? A.Component < B.Component : A.NeighborComponent < B.NeighborComponent;
+		});
+		int32 LastLink = FirstLink;
+		for (int32 i = FirstLink; i < Links.Num(); ++i) {
+			if (i == FirstLink || Links[i].Component != Links[LastLink - 1].Component || Links[i].NeighborComponent != Links[LastLink - 1].NeighborComponent) {
+				Links[LastLink++] = Links[i];
+			}
+		}
+		Links.SetNum(LastLink, false);
+		LinkOffsets[Tile + 1] = Links.Num();
+	}
+	Links.Shrink();
+}
+
+void FSpiderNavTiles::BuildLandmarks(int32 LandmarksNum)
+{
+	// temporary grid is only needed for Dijkstra from landmarks
+	const int32 NodesNum = Locations.Num();
+	TArray<FVector> WholeLocations;
+	TArray<FVector> WholeNormals;
+	WholeLocations.SetNumUninitialized(NodesNum);
+	WholeNormals.SetNumUninitialized(NodesNum);
+	for (int32 Tile = 0; Tile != TileCoords.Num(); ++Tile) {
+		for (int32 Node = NodeOffsets[Tile]; Node != NodeOffsets[Tile + 1]; ++Node) {
+			WholeLocations[Node] = GetLocation(Tile, Node);
+			WholeNormals[Node] = FSpiderNavGraph::DecodeNormal(Normals[Node]);
+		}
+	}
+
+	TArray<int32> WholeEdgeOffsets = EdgeOffsets;
+	TArray<int32> WholeEdgeTargets = EdgeTargets;
+	FSpiderNavGraph WholeGraph;
+	WholeGraph.BuildFromRows(MoveTemp(WholeLocations), MoveTemp(WholeNormals), MoveTemp(WholeEdgeOffsets), MoveTemp(WholeEdgeTargets), CellSize);
+	Landmarks.Build(WholeGraph, LandmarksNum);
+}
+
+int32 FSpiderNavTiles::FindTile(const FVector& Location) const
+{
+	const int32* Tile = TilesByCoords.Find(GetTileCoords(Location));
+	return Tile ? *Tile : INDEX_NONE;
+}
+
+int32 FSpiderNavTiles::FindNodeTile(int32 Node) const
+{
+	// the last tile which starts at or before node
+	int32 First = 0;
+	int32 Last = TileCoords.Num();
+	while (Last - First > 1) {
+		const int32 Middle = (First + Last) / 2;
+		if (NodeOffsets[Middle] <= Node) {
+			First = Middle;
+		} else {
+			Last = Middle;
+		}
+	}
+	return First;
+}
+
+float FSpiderNavTiles::GetDistanceSquaredToTile(int32 Tile, const FVector& Location) const
+{
+	const FVector Min = GetTileOrigin(Tile);
+	return FBox(Min, Min + FVector(TileSize)).ComputeSquaredDistanceToPoint(Location);
+}
+
+SIZE_T FSpiderNavTiles::GetAllocatedSize() const
+{
+	return NodeOffsets.GetAllocatedSize() + Locations.GetAllocatedSize() + Normals.GetAllocatedSize()
+		+ EdgeOffsets.GetAllocatedSize() + EdgeTargets.GetAllocatedSize()
+		+ ComponentOffsets.GetAllocatedSize() + NodeComponents.GetAllocatedSize() + LinkOffsets.GetAllocatedSize() + Links.GetAllocatedSize()
+		+ TileCoords.GetAllocatedSize() + TilesByCoords.GetAllocatedSize() + Landmarks.GetAllocatedSize();
+}
+
+FIntVector FSpiderNavTiles::GetTileCoords(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt(Location.X / TileSize), FMath::FloorToInt(Location.Y / TileSize), FMath::FloorToInt(Location.Z / TileSize));
+}
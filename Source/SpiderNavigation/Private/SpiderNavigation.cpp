@@ -22,6 +22,12 @@
 
 #include "SpiderNavigation.h"
 #include "SpiderNavigationModule.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopeLock.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
 
 DEFINE_LOG_CATEGORY(SpiderNAV_LOG);
 
@@ -31,295 +37,1695 @@ ASpiderNavigation::ASpiderNavigation()
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 	bAutoLoadGrid = true;
+	bLoadGridAsync = false;
+	bGridReady = false;
+	GridLoadId = 0;
 	DebugLinesThickness = 0.0f;
+	PathCacheSize = 256;
+	bUseFlowFields = false;
+	FlowFieldMaxCost = 0.0f;
+	FlowFieldsCacheSize = 4;
+	AgentPlannerMaxNodesNum = 65536;
+	LastQueryId = 0;
+	SearchMode = ESpiderNavSearchMode::AStar;
+	HeuristicMode = ESpiderNavHeuristic::Euclidean;
+	LandmarksNum = 8;
+	StorageMode = ESpiderNavStorageMode::Full;
+	QuantizationStep = 0.5f;
+	TimeSlicedMaxExpandedNodes = 2000;
+	TimeSlicedMaxMicroseconds = 1000.0f;
+	NextTimeSlicedQuery = 0;
+	PathRequestsNum = 0;
+	MergedPathRequestsNum = 0;
+	bStreamTiles = false;
+	StreamingTileSize = 4000.0f;
+	StreamingRadius = 6000.0f;
+	StreamingMemoryBudgetMB = 64.0f;
+	StreamingUpdateInterval = 0.5f;
+	StreamingRequestTimeout = 10.0f;
+	bStreamingInProgress = false;
+	TimeToStreamingUpdate = 0.0f;
+	StreamingBytesPerNode = 256.0f;
+
+	Graph = MakeShared<FSpiderNavGraph, ESPMode::ThreadSafe>();
+}
+
+bool ASpiderNavigation::IsReadyForFinishDestroy()
+{
+	return Super::IsReadyForFinishDestroy() && PendingQueriesNum.GetValue() == 0;
 }
 
 // Called when the game starts or when spawned
 void ASpiderNavigation::BeginPlay()
 {
 	Super::BeginPlay();
-	if (bAutoLoadGrid) {
+	PathCache.SetCapacity(PathCacheSize);
+	if (bAutoLoadGrid && bLoadGridAsync) {
+		LoadGridAsync();
+	} else if (bAutoLoadGrid) {
 		LoadGrid();
 	}
 }
 
-// Called every frame
-void ASpiderNavigation::Tick(float DeltaTime)
+// Called every frame
+void ASpiderNavigation::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	ProcessPathRequests();
+	ProcessTimeSlicedQueries();
+
+	if (StreamingTiles.IsValid() && bGridReady) {
+		TimeToStreamingUpdate -= DeltaTime;
+		if (TimeToStreamingUpdate <= 0.0f) {
+			TimeToStreamingUpdate = StreamingUpdateInterval;
+			UpdateStreaming(false);
+		}
+	}
+}
+
+int32 ASpiderNavigation::GetNavNodesCount()
+{
+	return Graph->Num();
+}
+
+TArray<FVector> ASpiderNavigation::FindPath(FVector Start, FVector End, bool& bFoundCompletePath)
+{
+	TArray<FVector> Path;
+	FindPathInto(Start, End, Path, bFoundCompletePath);
+	return Path;
+}
+
+bool ASpiderNavigation::FindPathInto(FVector Start, FVector End, TArray<FVector>& OutPath, bool& bFoundCompletePath)
+{
+	check(IsInGameThread());
+	if (!CheckGridReady(TEXT("FindPathInto"))) {
+		OutPath.Reset();
+		bFoundCompletePath = false;
+		return false;
+	}
+	FindLocationsPath(*Graph, Start, End, OutPath, NodesPathBuffer, bFoundCompletePath);
+	return OutPath.Num() > 0;
+}
+
+TArray<FVector> ASpiderNavigation::FindLocationsPath(const FSpiderNavGraph& NavGraph, FVector Start, FVector End, bool& bFoundCompletePath)
+{
+	TArray<FVector> Path;
+	TArray<int32> NodesPath;
+	FindLocationsPath(NavGraph, Start, End, Path, NodesPath, bFoundCompletePath);
+	return Path;
+}
+
+void ASpiderNavigation::FindLocationsPath(const FSpiderNavGraph& NavGraph, FVector Start, FVector End, TArray<FVector>& OutPath, TArray<int32>& OutNodesPath, bool& bFoundCompletePath)
+{
+	int32 StartIndex = FindClosestNode(NavGraph, Start);
+	int32 EndIndex = FindClosestNode(NavGraph, End);
+	FindNodesPath(NavGraph, StartIndex, EndIndex, OutNodesPath, bFoundCompletePath);
+
+	// path to a tile which is not streamed in ends at the closest node of streamed tiles
+	if (!IsLocationStreamedIn(NavGraph, End)) {
+		bFoundCompletePath = false;
+	}
+
+	// capacity of OutPath is kept, so the same buffer does not reallocate for paths which are not longer than before
+	OutPath.SetNumUninitialized(OutNodesPath.Num(), false);
+	for (int32 i = 0; i < OutNodesPath.Num(); i++) {
+		OutPath[i] = NavGraph.GetLocation(OutNodesPath[i]);
+	}
+}
+
+bool ASpiderNavigation::UpdateLocationHandle(FSpiderNavLocationHandle& Handle, FVector Location, FVector& NodeLocation, FVector& NodeNormal)
+{
+	const FSpiderNavGraph& NavGraph = *Graph;
+	const int32 NodeIndex = FindClosestNode(NavGraph, Location, Handle);
+	if (NodeIndex == INDEX_NONE) {
+		return false;
+	}
+
+	NodeLocation = NavGraph.GetLocation(NodeIndex);
+	NodeNormal = NavGraph.GetNormal(NodeIndex);
+
+	return true;
+}
+
+int32 ASpiderNavigation::FindPathAsync(FVector Start, FVector End, const FSpiderNavPathQueryDelegate& OnPathFound)
+{
+	if (!CheckGridReady(TEXT("FindPathAsync"))) {
+		return 0;
+	}
+
+	const int32 QueryId = StartQuery();
+	TWeakObjectPtr<ASpiderNavigation> WeakThis(this);
+	FSpiderNavGraphPtr QueryGraph = Graph;
+
+	PendingQueriesNum.Increment();
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [this, WeakThis, QueryGraph, QueryId, Start, End, OnPathFound]() {
+		bool bFoundCompletePath = false;
+		TArray<FVector> Path = FindLocationsPath(*QueryGraph, Start, End, bFoundCompletePath);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, QueryId, Path, bFoundCompletePath, OnPathFound]() {
+			ASpiderNavigation* Navigation = WeakThis.Get();
+			if (Navigation && Navigation->FinishQuery(QueryId)) {
+				OnPathFound.ExecuteIfBound(QueryId, Path, bFoundCompletePath);
+			}
+		});
+		PendingQueriesNum.Decrement();
+	});
+
+	return QueryId;
+}
+
+int32 ASpiderNavigation::FindPathTimeSliced(FVector Start, FVector End, const FSpiderNavPathQueryDelegate& OnPathFound)
+{
+	if (!CheckGridReady(TEXT("FindPathTimeSliced"))) {
+		return 0;
+	}
+
+	TUniquePtr<FSpiderNavTimeSlicedQuery> Query = MakeUnique<FSpiderNavTimeSlicedQuery>();
+	Query->QueryId = StartQuery();
+	Query->Graph = Graph;
+	Query->OnPathFound = OnPathFound;
+
+	const FSpiderNavGraph& NavGraph = *Graph;
+	const int32 StartIndex = FindClosestNode(NavGraph, Start);
+	const int32 EndIndex = FindClosestNode(NavGraph, End);
+	Query->bEndStreamedIn = IsLocationStreamedIn(NavGraph, End);
+
+	// the result is delivered in Tick even if it is known right now, so callers get it the same way
+	if (StartIndex == INDEX_NONE || EndIndex == INDEX_NONE) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Not found closest nodes"));
+		Query->bFinished = true;
+	} else if (PathCache.Find(NavGraph.Id, StartIndex, EndIndex, Query->NodesPath, Query->bFoundCompletePath)) {
+		Query->bFinished = true;
+	} else {
+		Query->Context = SearchContexts.Acquire();
+		BeginNodesPath(NavGraph, *Query->Context, Query->State, StartIndex, EndIndex);
+	}
+
+	const int32 QueryId = Query->QueryId;
+	TimeSlicedQueries.Add(MoveTemp(Query));
+
+	return QueryId;
+}
+
+void ASpiderNavigation::ProcessTimeSlicedQueries()
+{
+	if (!TimeSlicedQueries.Num()) {
+		return;
+	}
+
+	// time is checked after each chunk of expansions, reading the clock for every node would cost more than expansion itself
+	const int32 ChunkSize = 64;
+	const double EndTime = TimeSlicedMaxMicroseconds > 0.0f ? FPlatformTime::Seconds() + TimeSlicedMaxMicroseconds * 0.000001 : MAX_dbl;
+	int32 ExpandedNodesLeft = TimeSlicedMaxExpandedNodes > 0 ? TimeSlicedMaxExpandedNodes : MAX_int32;
+
+	while (TimeSlicedQueries.Num() && ExpandedNodesLeft > 0 && FPlatformTime::Seconds() < EndTime) {
+		// queries get chunks in turn, so one long query does not hold others
+		if (NextTimeSlicedQuery >= TimeSlicedQueries.Num()) {
+			NextTimeSlicedQuery = 0;
+		}
+		FSpiderNavTimeSlicedQuery& Query = *TimeSlicedQueries[NextTimeSlicedQuery];
+
+		if (!Query.bFinished && CancelledQueries.Contains(Query.QueryId)) {
+			Query.bFinished = true;
+		}
+
+		if (!Query.bFinished) {
+			const int32 ExpandedNodesBefore = Query.Context->ExpandedNodesNum;
+			if (StepNodesPath(*Query.Graph, *Query.Context, Query.State, FMath::Min(ChunkSize, ExpandedNodesLeft))) {
+				FinishNodesPath(*Query.Context, Query.State, Query.NodesPath, Query.bFoundCompletePath);
+				if (Query.NodesPath.Num()) {
+					PathCache.Add(Query.Graph->Id, Query.State.StartIndex, Query.State.RequestedEndIndex, Query.NodesPath, Query.bFoundCompletePath);
+				}
+				Query.bFinished = true;
+			}
+			ExpandedNodesLeft -= Query.Context->ExpandedNodesNum - ExpandedNodesBefore;
+		}
+
+		if (!Query.bFinished) {
+			NextTimeSlicedQuery++;
+			continue;
+		}
+
+		TUniquePtr<FSpiderNavTimeSlicedQuery> FinishedQuery = MoveTemp(TimeSlicedQueries[NextTimeSlicedQuery]);
+		TimeSlicedQueries.RemoveAt(NextTimeSlicedQuery);
+		if (FinishedQuery->Context.IsValid()) {
+			SearchContexts.Release(MoveTemp(FinishedQuery->Context));
+		}
+
+		// delegate can start new queries, so it is called when the query is not in the list anymore
+		if (FinishQuery(FinishedQuery->QueryId)) {
+			TArray<FVector> Path;
+			Path.Reserve(FinishedQuery->NodesPath.Num());
+			for (int32 NodeIndex : FinishedQuery->NodesPath) {
+				Path.Add(FinishedQuery->Graph->GetLocation(NodeIndex));
+			}
+			FinishedQuery->OnPathFound.ExecuteIfBound(FinishedQuery->QueryId, Path, FinishedQuery->bFoundCompletePath && FinishedQuery->bEndStreamedIn);
+		}
+	}
+}
+
+int32 ASpiderNavigation::RequestPath(FVector Start, FVector End, const FSpiderNavPathQueryDelegate& OnPathFound)
+{
+	if (!CheckGridReady(TEXT("RequestPath"))) {
+		return 0;
+	}
+
+	const int32 RequestIndex = PathRequests.AddDefaulted();
+	FSpiderNavPathRequest& Request = PathRequests[RequestIndex];
+	Request.QueryId = StartQuery();
+	Request.Graph = Graph;
+	Request.StartIndex = FindClosestNode(*Graph, Start);
+	Request.EndIndex = FindClosestNode(*Graph, End);
+	Request.bEndStreamedIn = IsLocationStreamedIn(*Graph, End);
+	Request.OnPathFound = OnPathFound;
+	PathRequestsNum++;
+
+	return Request.QueryId;
+}
+
+void ASpiderNavigation::ProcessPathRequests()
+{
+	if (!PathRequests.Num()) {
+		return;
+	}
+
+	// delegates can make new requests, they wait for the next frame
+	TArray<FSpiderNavPathRequest> Requests = MoveTemp(PathRequests);
+	PathRequests.Reset();
+
+	struct FResult
+	{
+		const FSpiderNavGraph* Graph;
+		TArray<FVector> Path;
+		bool bFoundCompletePath;
+	};
+	TArray<FResult> Results;
+	TArray<int32> RequestResults;
+	RequestResults.SetNumUninitialized(Requests.Num());
+	TMap<uint64, int32> ResultsByNodes;
+	TArray<int32> NodesPath;
+
+	for (int32 i = 0; i < Requests.Num(); i++) {
+		const FSpiderNavPathRequest& Request = Requests[i];
+		const uint64 Key = ((uint64)(uint32)Request.StartIndex << 32) | (uint32)Request.EndIndex;
+
+		// requests made before and after loading of grid have the same nodes with different meaning
+		const int32* ExistingResult = ResultsByNodes.Find(Key);
+		if (ExistingResult && Results[*ExistingResult].Graph == Request.Graph.Get()) {
+			RequestResults[i] = *ExistingResult;
+			MergedPathRequestsNum++;
+			continue;
+		}
+
+		const int32 ResultIndex = Results.AddDefaulted();
+		FResult& Result = Results[ResultIndex];
+		Result.Graph = Request.Graph.Get();
+		Result.bFoundCompletePath = false;
+		FindNodesPath(*Request.Graph, Request.StartIndex, Request.EndIndex, NodesPath, Result.bFoundCompletePath);
+		Result.Path.Reserve(NodesPath.Num());
+		for (int32 NodeIndex : NodesPath) {
+			Result.Path.Add(Request.Graph->GetLocation(NodeIndex));
+		}
+
+		ResultsByNodes.Add(Key, ResultIndex);
+		RequestResults[i] = ResultIndex;
+	}
+
+	// cancellation is checked right before delivery, since delegates can cancel other requests of the same frame
+	for (int32 i = 0; i < Requests.Num(); i++) {
+		if (FinishQuery(Requests[i].QueryId)) {
+			const FResult& Result = Results[RequestResults[i]];
+			Requests[i].OnPathFound.ExecuteIfBound(Requests[i].QueryId, Result.Path, Result.bFoundCompletePath && Requests[i].bEndStreamedIn);
+		}
+	}
+}
+
+bool ASpiderNavigation::IsReachable(FVector Start, FVector End)
+{
+	const FSpiderNavGraph& NavGraph = *Graph;
+	const int32 StartIndex = FindClosestNode(NavGraph, Start);
+	const int32 EndIndex = FindClosestNode(NavGraph, End);
+
+	return StartIndex != INDEX_NONE && EndIndex != INDEX_NONE && NavGraph.IsReachable(StartIndex, EndIndex);
+}
+
+void ASpiderNavigation::CancelAsyncQuery(int32 QueryId)
+{
+	// results of finished queries have been delivered already, there is nothing to cancel
+	if (PendingQueries.Contains(QueryId)) {
+		CancelledQueries.Add(QueryId);
+	}
+}
+
+int32 ASpiderNavigation::StartQuery()
+{
+	const int32 QueryId = ++LastQueryId;
+	PendingQueries.Add(QueryId);
+	return QueryId;
+}
+
+bool ASpiderNavigation::FinishQuery(int32 QueryId)
+{
+	PendingQueries.Remove(QueryId);
+	return CancelledQueries.Remove(QueryId) == 0;
+}
+
+void ASpiderNavigation::FindNodesPath(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath)
+{
+	if (PathCache.Find(NavGraph.Id, StartIndex, EndIndex, OutPath, bFoundCompletePath)) {
+		return;
+	}
+
+	SearchNodesPath(NavGraph, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+
+	if (OutPath.Num()) {
+		PathCache.Add(NavGraph.Id, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+	}
+}
+
+void ASpiderNavigation::SearchNodesPath(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath)
+{
+	// partial path to unreachable end is found by A-star to the closest reachable node, other modes would only waste time
+	const bool bIsReachable = StartIndex == INDEX_NONE || EndIndex == INDEX_NONE || NavGraph.IsReachable(StartIndex, EndIndex);
+
+	if (bIsReachable && SearchMode == ESpiderNavSearchMode::Hierarchical) {
+		FindNodesPathHierarchical(NavGraph, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+		return;
+	}
+	if (bIsReachable && SearchMode == ESpiderNavSearchMode::ContractionHierarchy) {
+		FindNodesPathContractionHierarchy(NavGraph, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+		return;
+	}
+	if (bIsReachable && SearchMode == ESpiderNavSearchMode::Bidirectional) {
+		FindNodesPathBidirectional(NavGraph, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+		return;
+	}
+
+	TUniquePtr<FSpiderNavSearchContext> Context = SearchContexts.Acquire();
+	FindNodesPath(NavGraph, *Context, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+	SearchContexts.Release(MoveTemp(Context));
+}
+
+void ASpiderNavigation::FindNodesPath(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath, const TBitArray<>* AllowedClusters, bool bAllowLandmarks)
+{
+	if (StartIndex == INDEX_NONE || EndIndex == INDEX_NONE) {
+		//GEngine->AddOnScreenDebugMessage(0, 1.0f, FColor::Yellow, TEXT("Not found closest nodes"));
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Not found closest nodes"));
+		OutPath.Reset();
+		return;
+	}
+
+	FSpiderNavAStarState State;
+	BeginNodesPath(NavGraph, Context, State, StartIndex, EndIndex, AllowedClusters, bAllowLandmarks);
+	StepNodesPath(NavGraph, Context, State, MAX_int32);
+
+	FinishNodesPath(Context, State, OutPath, bFoundCompletePath);
+}
+
+void ASpiderNavigation::BeginNodesPath(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, FSpiderNavAStarState& State, int32 StartIndex, int32 EndIndex, const TBitArray<>* AllowedClusters, bool bAllowLandmarks)
+{
+	Context.Reset(NavGraph.Num());
+
+	State = FSpiderNavAStarState();
+	State.RequestedEndIndex = EndIndex;
+
+	// search of unreachable end would expand the whole component of start, so it goes to the closest node which can be reached
+	if (!NavGraph.IsReachable(StartIndex, EndIndex)) {
+		EndIndex = NavGraph.FindClosestNodeInComponent(NavGraph.ComponentIds[StartIndex], NavGraph.GetLocation(EndIndex));
+		State.bEndReplaced = true;
+	}
+
+	State.StartIndex = StartIndex;
+	State.EndIndex = EndIndex;
+	State.EndLocation = NavGraph.GetLocation(EndIndex);
+	State.AllowedClusters = AllowedClusters;
+	if (bAllowLandmarks && HeuristicMode == ESpiderNavHeuristic::Landmarks && !NavGraph.Landmarks.IsEmpty()) {
+		State.Landmarks = &NavGraph.Landmarks;
+	}
+
+	Context.GetNode(StartIndex).bOpened = true;
+	Context.PushOpenNode(StartIndex);
+}
+
+bool ASpiderNavigation::StepNodesPath(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, FSpiderNavAStarState& State, int32 MaxExpandedNodesNum)
+{
+	for (int32 Step = 0; Step < MaxExpandedNodesNum; Step++) {
+		if (!Context.HasOpenNodes()) {
+			return true;
+		}
+
+		int32 NodeIndex = Context.PopOpenNode();
+		FSpiderNavSearchNode& SearchNode = Context.GetNode(NodeIndex);
+		SearchNode.bClosed = true;
+
+		if (NodeIndex == State.EndIndex) {
+			State.bFoundEnd = true;
+			return true;
+		}
+
+		if (NodeIndex != State.StartIndex && SearchNode.F < State.ClosestF) {
+			State.ClosestF = SearchNode.F;
+			State.ClosestIndex = NodeIndex;
+		}
+
+		const int32 EdgesEnd = NavGraph.GetEdgesEnd(NodeIndex);
+		for (int32 Edge = NavGraph.GetEdgesBegin(NodeIndex); Edge != EdgesEnd; ++Edge) {
+			const int32 NeighborIndex = NavGraph.EdgeTargets[Edge];
+			FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+
+			if (State.AllowedClusters && !(*State.AllowedClusters)[NavGraph.Clusters.ClusterIds[NeighborIndex]]) {
+				continue;
+			}
+
+			// the distance between current node and the neighbor is precomputed
+			float NewG = SearchNode.G + NavGraph.EdgeCosts[Edge];
+
+			if (SearchNeighbor.bClosed) {
+				// bounds from landmarks are not consistent, so closed node can be reached with smaller cost later
+				if (!State.Landmarks || NewG >= SearchNeighbor.G) {
+					continue;
+				}
+				SearchNeighbor.bClosed = false;
+				SearchNeighbor.bOpened = false;
+			}
+
+			// check if the neighbor has not been inspected yet, or
+			// can be reached with smaller cost from the current node
+			if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+				SearchNeighbor.G = NewG;
+				float H = (NavGraph.GetLocation(NeighborIndex) - State.EndLocation).Size();
+				if (State.Landmarks) {
+					H = FMath::Max(H, State.Landmarks->GetLowerBound(NeighborIndex, State.EndIndex));
+				}
+				SearchNeighbor.F = NewG + H;
+				SearchNeighbor.ParentIndex = NodeIndex;
+
+				if (!SearchNeighbor.bOpened) {
+					SearchNeighbor.bOpened = true;
+					Context.PushOpenNode(NeighborIndex);
+				} else {
+					// the neighbor can be reached with smaller cost.
+					// Since its f value has been decreased, we have to
+					// move it up in the open list
+					Context.DecreaseOpenNode(NeighborIndex);
+				}
+			}
+		}
+	}
+
+	return !Context.HasOpenNodes();
+}
+
+void ASpiderNavigation::FinishNodesPath(const FSpiderNavSearchContext& Context, const FSpiderNavAStarState& State, TArray<int32>& OutPath, bool& bFoundCompletePath)
+{
+	if (State.bFoundEnd && !State.bEndReplaced) {
+		bFoundCompletePath = true;
+		BuildNodesPathFromEndNode(Context, State.EndIndex, OutPath);
+		return;
+	}
+
+	UE_LOG(SpiderNAV_LOG, Warning, TEXT("Not found complete path"));
+
+	if (State.bFoundEnd) {
+		bFoundCompletePath = false;
+		BuildNodesPathFromEndNode(Context, State.EndIndex, OutPath);
+		return;
+	}
+
+	if (State.ClosestIndex != INDEX_NONE) {
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("Min F = %f"), State.ClosestF);
+		bFoundCompletePath = false;
+		BuildNodesPathFromEndNode(Context, State.ClosestIndex, OutPath);
+		return;
+	}
+
+	OutPath.Reset();
+}
+
+void ASpiderNavigation::FindNodesPathHierarchical(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath)
+{
+	OutPath.Reset();
+	bFoundCompletePath = false;
+
+	const FSpiderNavClusters& Clusters = NavGraph.Clusters;
+	TUniquePtr<FSpiderNavSearchContext> Context = SearchContexts.Acquire();
+
+	if (Clusters.IsEmpty() || StartIndex == INDEX_NONE || EndIndex == INDEX_NONE || Clusters.ClusterIds[StartIndex] == Clusters.ClusterIds[EndIndex]) {
+		FindNodesPath(NavGraph, *Context, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+		SearchContexts.Release(MoveTemp(Context));
+		return;
+	}
+
+	// buffers of context keep their memory between queries
+	TArray<TPair<int32, float>>& StartEntrances = Context->StartEntrances;
+	TArray<TPair<int32, float>>& EndEntrances = Context->EndEntrances;
+	SearchClusterEntrances(NavGraph, *Context, StartIndex, StartEntrances);
+	SearchClusterEntrances(NavGraph, *Context, EndIndex, EndEntrances);
+
+	// abstract graph is much smaller than grid, so its contexts come from their own pool and are never resized to grid
+	TUniquePtr<FSpiderNavSearchContext> AbstractContext = AbstractSearchContexts.Acquire();
+	TArray<int32>& AbstractPath = Context->AbstractPath;
+	const bool bFoundAbstractPath = SearchAbstractPath(NavGraph, *AbstractContext, StartIndex, EndIndex, StartEntrances, EndEntrances, AbstractPath);
+	AbstractSearchContexts.Release(MoveTemp(AbstractContext));
+
+	if (bFoundAbstractPath) {
+		TBitArray<>& Corridor = Context->Corridor;
+		Corridor.Init(false, Clusters.ClustersNum);
+		Corridor[Clusters.ClusterIds[StartIndex]] = true;
+		Corridor[Clusters.ClusterIds[EndIndex]] = true;
+		for (int32 AbstractIndex : AbstractPath) {
+			Corridor[Clusters.ClusterIds[Clusters.AbstractNodes[AbstractIndex]]] = true;
+		}
+		FindNodesPath(NavGraph, *Context, StartIndex, EndIndex, OutPath, bFoundCompletePath, &Corridor);
+	}
+
+	if (!bFoundCompletePath) {
+		// end is not reachable through clusters, the whole grid is searched for partial path
+		FindNodesPath(NavGraph, *Context, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+	}
+
+	SearchContexts.Release(MoveTemp(Context));
+}
+
+void ASpiderNavigation::FindNodesPathContractionHierarchy(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath)
+{
+	OutPath.Reset();
+	bFoundCompletePath = false;
+
+	TUniquePtr<FSpiderNavSearchContext> Context = SearchContexts.Acquire();
+
+	if (!NavGraph.ContractionHierarchy.IsEmpty() && StartIndex != INDEX_NONE && EndIndex != INDEX_NONE) {
+		TUniquePtr<FSpiderNavSearchContext> BackwardContext = SearchContexts.Acquire();
+		bFoundCompletePath = NavGraph.ContractionHierarchy.FindPath(*Context, *BackwardContext, StartIndex, EndIndex, OutPath);
+		SearchContexts.Release(MoveTemp(BackwardContext));
+	}
+
+	if (!bFoundCompletePath) {
+		FindNodesPath(NavGraph, *Context, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+	}
+
+	SearchContexts.Release(MoveTemp(Context));
+}
+
+void ASpiderNavigation::FindNodesPathBidirectional(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath)
+{
+	OutPath.Reset();
+	bFoundCompletePath = false;
+
+	TUniquePtr<FSpiderNavSearchContext> Context = SearchContexts.Acquire();
+
+	if (StartIndex != INDEX_NONE && EndIndex != INDEX_NONE) {
+		TUniquePtr<FSpiderNavSearchContext> BackwardContext = SearchContexts.Acquire();
+		bFoundCompletePath = FindNodesPathBidirectional(NavGraph, *Context, *BackwardContext, StartIndex, EndIndex, OutPath);
+		SearchContexts.Release(MoveTemp(BackwardContext));
+	}
+
+	if (!bFoundCompletePath) {
+		FindNodesPath(NavGraph, *Context, StartIndex, EndIndex, OutPath, bFoundCompletePath);
+	}
+
+	SearchContexts.Release(MoveTemp(Context));
+}
+
+bool ASpiderNavigation::FindNodesPathBidirectional(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& ForwardContext, FSpiderNavSearchContext& BackwardContext, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath)
+{
+	OutPath.Reset();
+
+	ForwardContext.Reset(NavGraph.Num());
+	BackwardContext.Reset(NavGraph.Num());
+
+	if (StartIndex == EndIndex) {
+		OutPath.Add(StartIndex);
+		return true;
+	}
+
+	// potential of forward search, backward search uses the negated one. Both directions get consistent keys,
+	// so the best path is found when sum of the lowest keys reaches its cost. Bounds from landmarks are rounded and not consistent,
+	// closed nodes are not reopened here, so with them the path can be longer than the best one by a few quantization steps
+	auto GetPotential = [&](int32 Index) {
+		return 0.5f * (EstimateCost(NavGraph, Index, EndIndex) - EstimateCost(NavGraph, Index, StartIndex));
+	};
+
+	FSpiderNavSearchContext* Contexts[2] = { &ForwardContext, &BackwardContext };
+	const int32 SourceIndexes[2] = { StartIndex, EndIndex };
+	const float PotentialSigns[2] = { 1.0f, -1.0f };
+	for (int32 Direction = 0; Direction < 2; Direction++) {
+		FSpiderNavSearchNode& SourceNode = Contexts[Direction]->GetNode(SourceIndexes[Direction]);
+		SourceNode.F = PotentialSigns[Direction] * GetPotential(SourceIndexes[Direction]);
+		SourceNode.bOpened = true;
+		Contexts[Direction]->PushOpenNode(SourceIndexes[Direction]);
+	}
+
+	float BestCost = MAX_flt;
+	int32 MeetingIndex = INDEX_NONE;
+
+	while (ForwardContext.HasOpenNodes() && BackwardContext.HasOpenNodes()) {
+		const float ForwardKey = ForwardContext.FindNode(ForwardContext.PeekOpenNode())->F;
+		const float BackwardKey = BackwardContext.FindNode(BackwardContext.PeekOpenNode())->F;
+		if (ForwardKey + BackwardKey >= BestCost) {
+			break;
+		}
+
+		const int32 Direction = ForwardKey <= BackwardKey ? 0 : 1;
+		FSpiderNavSearchContext& Context = *Contexts[Direction];
+		const FSpiderNavSearchContext& OtherContext = *Contexts[1 - Direction];
+
+		const int32 NodeIndex = Context.PopOpenNode();
+		FSpiderNavSearchNode& SearchNode = Context.GetNode(NodeIndex);
+		SearchNode.bClosed = true;
+
+		const int32 EdgesEnd = NavGraph.GetEdgesEnd(NodeIndex);
+		for (int32 Edge = NavGraph.GetEdgesBegin(NodeIndex); Edge != EdgesEnd; ++Edge) {
+			const int32 NeighborIndex = NavGraph.EdgeTargets[Edge];
+			FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+
+			if (SearchNeighbor.bClosed) {
+				continue;
+			}
+
+			// edges are symmetric, so backward search goes by the same edges
+			const float NewG = SearchNode.G + NavGraph.EdgeCosts[Edge];
+			if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+				SearchNeighbor.G = NewG;
+				SearchNeighbor.F = NewG + PotentialSigns[Direction] * GetPotential(NeighborIndex);
+				SearchNeighbor.ParentIndex = NodeIndex;
+
+				if (!SearchNeighbor.bOpened) {
+					SearchNeighbor.bOpened = true;
+					Context.PushOpenNode(NeighborIndex);
+				} else {
+					Context.DecreaseOpenNode(NeighborIndex);
+				}
+
+				const FSpiderNavSearchNode* OtherNode = OtherContext.FindNode(NeighborIndex);
+				if (OtherNode && OtherNode->bOpened && NewG + OtherNode->G < BestCost) {
+					BestCost = NewG + OtherNode->G;
+					MeetingIndex = NeighborIndex;
+				}
+			}
+		}
+	}
+
+	if (MeetingIndex == INDEX_NONE) {
+		return false;
+	}
+
+	BuildNodesPathFromEndNode(ForwardContext, MeetingIndex, OutPath);
+	const FSpiderNavSearchNode* IterNode = BackwardContext.FindNode(MeetingIndex);
+	while (IterNode && IterNode->ParentIndex > -1) {
+		OutPath.Add(IterNode->ParentIndex);
+		IterNode = BackwardContext.FindNode(IterNode->ParentIndex);
+	}
+
+	return true;
+}
+
+float ASpiderNavigation::EstimateCost(const FSpiderNavGraph& NavGraph, int32 FromIndex, int32 ToIndex) const
+{
+	float Cost = (NavGraph.GetLocation(FromIndex) - NavGraph.GetLocation(ToIndex)).Size();
+	if (HeuristicMode == ESpiderNavHeuristic::Landmarks && !NavGraph.Landmarks.IsEmpty()) {
+		Cost = FMath::Max(Cost, NavGraph.Landmarks.GetLowerBound(FromIndex, ToIndex));
+	}
+	return Cost;
+}
+
+void ASpiderNavigation::SearchClusterEntrances(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 NodeIndex, TArray<TPair<int32, float>>& OutEntrancesCosts)
+{
+	const FSpiderNavClusters& Clusters = NavGraph.Clusters;
+	const int32 ClusterId = Clusters.ClusterIds[NodeIndex];
+
+	Context.Reset(NavGraph.Num());
+	Context.GetNode(NodeIndex).bOpened = true;
+	Context.PushOpenNode(NodeIndex);
+
+	// Dijkstra inside the cluster, grid is undirected so costs are the same in both directions
+	while (Context.HasOpenNodes()) {
+		const int32 CurrentIndex = Context.PopOpenNode();
+		FSpiderNavSearchNode& SearchNode = Context.GetNode(CurrentIndex);
+		SearchNode.bClosed = true;
+
+		const int32 EdgesEnd = NavGraph.GetEdgesEnd(CurrentIndex);
+		for (int32 Edge = NavGraph.GetEdgesBegin(CurrentIndex); Edge != EdgesEnd; ++Edge) {
+			const int32 NeighborIndex = NavGraph.EdgeTargets[Edge];
+			if (Clusters.ClusterIds[NeighborIndex] != ClusterId) {
+				continue;
+			}
+
+			FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+			if (SearchNeighbor.bClosed) {
+				continue;
+			}
+
+			const float NewG = SearchNode.G + NavGraph.EdgeCosts[Edge];
+			if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+				SearchNeighbor.G = NewG;
+				SearchNeighbor.F = NewG;
+				SearchNeighbor.ParentIndex = CurrentIndex;
+
+				if (!SearchNeighbor.bOpened) {
+					SearchNeighbor.bOpened = true;
+					Context.PushOpenNode(NeighborIndex);
+				} else {
+					Context.DecreaseOpenNode(NeighborIndex);
+				}
+			}
+		}
+	}
+
+	OutEntrancesCosts.Reset();
+	for (int32 i = Clusters.EntrancesOffsets[ClusterId]; i < Clusters.EntrancesOffsets[ClusterId + 1]; i++) {
+		const int32 AbstractIndex = Clusters.Entrances[i];
+		const FSpiderNavSearchNode* SearchNode = Context.FindNode(Clusters.AbstractNodes[AbstractIndex]);
+		if (SearchNode && SearchNode->bClosed) {
+			OutEntrancesCosts.Emplace(AbstractIndex, SearchNode->G);
+		}
+	}
+}
+
+bool ASpiderNavigation::SearchAbstractPath(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 StartIndex, int32 EndIndex, const TArray<TPair<int32, float>>& StartEntrances, const TArray<TPair<int32, float>>& EndEntrances, TArray<int32>& OutAbstractPath)
+{
+	const FSpiderNavClusters& Clusters = NavGraph.Clusters;
+
+	// start and end nodes of grid are temporary inserted into abstract graph after its own nodes
+	const int32 VirtualStart = Clusters.AbstractNodes.Num();
+	const int32 VirtualEnd = VirtualStart + 1;
+	const FVector EndLocation = NavGraph.GetLocation(EndIndex);
+
+	const int32 EndClusterId = Clusters.ClusterIds[EndIndex];
+
+	Context.Reset(VirtualEnd + 1);
+	Context.GetNode(VirtualStart).bOpened = true;
+	Context.PushOpenNode(VirtualStart);
+
+	auto VisitNeighbor = [&](FSpiderNavSearchNode& SearchNode, int32 CurrentIndex, int32 NeighborIndex, float Cost) {
+		FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+		if (SearchNeighbor.bClosed) {
+			return;
+		}
+
+		const float NewG = SearchNode.G + Cost;
+		if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+			SearchNeighbor.G = NewG;
+			SearchNeighbor.F = NeighborIndex == VirtualEnd ? NewG : NewG + (NavGraph.GetLocation(Clusters.AbstractNodes[NeighborIndex]) - EndLocation).Size();
+			SearchNeighbor.ParentIndex = CurrentIndex;
+
+			if (!SearchNeighbor.bOpened) {
+				SearchNeighbor.bOpened = true;
+				Context.PushOpenNode(NeighborIndex);
+			} else {
+				Context.DecreaseOpenNode(NeighborIndex);
+			}
+		}
+	};
+
+	while (Context.HasOpenNodes()) {
+		const int32 CurrentIndex = Context.PopOpenNode();
+		FSpiderNavSearchNode& SearchNode = Context.GetNode(CurrentIndex);
+		SearchNode.bClosed = true;
+
+		if (CurrentIndex == VirtualEnd) {
+			BuildNodesPathFromEndNode(Context, CurrentIndex, OutAbstractPath);
+			// remove virtual start and end
+			OutAbstractPath.RemoveAt(OutAbstractPath.Num() - 1, 1, false);
+			OutAbstractPath.RemoveAt(0, 1, false);
+			return true;
+		}
+
+		if (CurrentIndex == VirtualStart) {
+			for (const TPair<int32, float>& Entrance : StartEntrances) {
+				VisitNeighbor(SearchNode, CurrentIndex, Entrance.Key, Entrance.Value);
+			}
+			continue;
+		}
+
+		for (int32 Edge = Clusters.EdgeOffsets[CurrentIndex]; Edge < Clusters.EdgeOffsets[CurrentIndex + 1]; ++Edge) {
+			VisitNeighbor(SearchNode, CurrentIndex, Clusters.EdgeTargets[Edge], Clusters.EdgeCosts[Edge]);
+		}
+
+		// cluster has only a few entrances, so they are scanned instead of being put into a map for each query
+		if (Clusters.ClusterIds[Clusters.AbstractNodes[CurrentIndex]] == EndClusterId) {
+			for (const TPair<int32, float>& Entrance : EndEntrances) {
+				if (Entrance.Key == CurrentIndex) {
+					VisitNeighbor(SearchNode, CurrentIndex, VirtualEnd, Entrance.Value);
+					break;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+void ASpiderNavigation::FindNodesPaths(const FSpiderNavGraph& NavGraph, const TArray<int32>& StartIndexes, const TArray<int32>& EndIndexes, TArray<TArray<int32>>& OutPaths, TArray<bool>& OutFoundCompletePaths)
+{
+	check(StartIndexes.Num() == EndIndexes.Num());
+	const int32 QueriesNum = StartIndexes.Num();
+
+	OutPaths.Reset();
+	OutPaths.SetNum(QueriesNum);
+	OutFoundCompletePaths.Init(false, QueriesNum);
+
+	// group queries which are not cached by end node
+	TArray<TArray<int32>> Groups;
+	TMap<int32, int32> GroupsByEndNode;
+	for (int32 i = 0; i < QueriesNum; i++) {
+		if (StartIndexes[i] == INDEX_NONE || EndIndexes[i] == INDEX_NONE) {
+			continue;
+		}
+		bool bFoundCompletePath = false;
+		if (PathCache.Find(NavGraph.Id, StartIndexes[i], EndIndexes[i], OutPaths[i], bFoundCompletePath)) {
+			OutFoundCompletePaths[i] = bFoundCompletePath;
+			continue;
+		}
+		int32* GroupIndex = GroupsByEndNode.Find(EndIndexes[i]);
+		if (!GroupIndex) {
+			GroupIndex = &GroupsByEndNode.Add(EndIndexes[i], Groups.AddDefaulted());
+		}
+		Groups[*GroupIndex].Add(i);
+	}
+
+	ParallelFor(Groups.Num(), [&](int32 GroupIndex) {
+		const TArray<int32>& Group = Groups[GroupIndex];
+		const int32 EndIndex = EndIndexes[Group[0]];
+
+		bool bSearchedFromEnd = false;
+		if (Group.Num() > 1) {
+			TArray<int32> GroupStartIndexes;
+			GroupStartIndexes.Reserve(Group.Num());
+			for (int32 Query : Group) {
+				if (!NavGraph.IsReachable(StartIndexes[Query], EndIndex)) {
+					GroupStartIndexes.Reset();
+					break;
+				}
+				GroupStartIndexes.Add(StartIndexes[Query]);
+			}
+			// unreachable agents would make search from the end expand the whole component
+			if (GroupStartIndexes.Num() == Group.Num()) {
+				TUniquePtr<FSpiderNavSearchContext> Context = SearchContexts.Acquire();
+				bSearchedFromEnd = SearchFromEndNode(NavGraph, *Context, EndIndex, GroupStartIndexes);
+				if (bSearchedFromEnd) {
+					for (int32 Query : Group) {
+						OutPaths[Query] = BuildNodesPathToEndNode(*Context, StartIndexes[Query]);
+						OutFoundCompletePaths[Query] = true;
+					}
+				}
+				SearchContexts.Release(MoveTemp(Context));
+			}
+		}
+
+		if (!bSearchedFromEnd) {
+			// single agent or some agents can not reach the end node, every one of them needs its own path
+			for (int32 Query : Group) {
+				bool bFoundCompletePath = false;
+				SearchNodesPath(NavGraph, StartIndexes[Query], EndIndex, OutPaths[Query], bFoundCompletePath);
+				OutFoundCompletePaths[Query] = bFoundCompletePath;
+			}
+		}
+
+		for (int32 Query : Group) {
+			if (OutPaths[Query].Num()) {
+				PathCache.Add(NavGraph.Id, StartIndexes[Query], EndIndex, OutPaths[Query], OutFoundCompletePaths[Query]);
+			}
+		}
+	});
+}
+
+bool ASpiderNavigation::SearchFromEndNode(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 EndIndex, const TArray<int32>& StartIndexes)
+{
+	Context.Reset(NavGraph.Num());
+
+	// distance to the box around all start nodes never overestimates distance to any of them
+	FBox StartsBox(ForceInit);
+	TMap<int32, int32> StartsToClose;
+	for (int32 StartIndex : StartIndexes) {
+		StartsBox += NavGraph.GetLocation(StartIndex);
+		StartsToClose.FindOrAdd(StartIndex)++;
+	}
+	int32 StartsToCloseNum = StartsToClose.Num();
+
+	Context.GetNode(EndIndex).bOpened = true;
+	Context.PushOpenNode(EndIndex);
+
+	while (Context.HasOpenNodes()) {
+		int32 NodeIndex = Context.PopOpenNode();
+		FSpiderNavSearchNode& SearchNode = Context.GetNode(NodeIndex);
+		SearchNode.bClosed = true;
+
+		if (StartsToClose.Contains(NodeIndex)) {
+			StartsToCloseNum--;
+			if (StartsToCloseNum == 0) {
+				return true;
+			}
+		}
+
+		const int32 EdgesEnd = NavGraph.GetEdgesEnd(NodeIndex);
+		for (int32 Edge = NavGraph.GetEdgesBegin(NodeIndex); Edge != EdgesEnd; ++Edge) {
+			const int32 NeighborIndex = NavGraph.EdgeTargets[Edge];
+			FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+
+			if (SearchNeighbor.bClosed) {
+				continue;
+			}
+
+			float NewG = SearchNode.G + NavGraph.EdgeCosts[Edge];
+			if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+				SearchNeighbor.G = NewG;
+				SearchNeighbor.F = NewG + FMath::Sqrt(StartsBox.ComputeSquaredDistanceToPoint(NavGraph.GetLocation(NeighborIndex)));
+				SearchNeighbor.ParentIndex = NodeIndex;
+
+				if (!SearchNeighbor.bOpened) {
+					SearchNeighbor.bOpened = true;
+					Context.PushOpenNode(NeighborIndex);
+				} else {
+					Context.DecreaseOpenNode(NeighborIndex);
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+TArray<int32> ASpiderNavigation::BuildNodesPathToEndNode(const FSpiderNavSearchContext& Context, int32 StartIndex)
+{
+	TArray<int32> Path;
+
+	Path.Add(StartIndex);
+
+	const FSpiderNavSearchNode* IterNode = Context.FindNode(StartIndex);
+	while (IterNode && IterNode->ParentIndex > -1) {
+		Path.Add(IterNode->ParentIndex);
+		IterNode = Context.FindNode(IterNode->ParentIndex);
+	}
+
+	return Path;
+}
+
+void ASpiderNavigation::GetPathCacheStats(int32& Hits, int32& Misses, int32& CachedPaths)
+{
+	PathCache.GetStats(Hits, Misses, CachedPaths);
+}
+
+void ASpiderNavigation::GetPathRequestStats(int32& Requests, int32& MergedRequests)
+{
+	Requests = PathRequestsNum;
+	MergedRequests = MergedPathRequestsNum;
+}
+
+void ASpiderNavigation::GetGridMemoryStats(int32& TotalBytes, float& BytesPerNode)
+{
+	TotalBytes = (int32)Graph->GetAllocatedSize();
+	BytesPerNode = Graph->Num() > 0 ? (float)TotalBytes / Graph->Num() : 0.0f;
+}
+
+float ASpiderNavigation::BenchmarkFindPath(int32 QueriesNum)
+{
+	const FSpiderNavGraph& NavGraph = *Graph;
+	if (NavGraph.Num() < 2 || QueriesNum <= 0) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Benchmark needs loaded grid"));
+		return 0.0f;
+	}
+
+	TUniquePtr<FSpiderNavSearchContext> Context = SearchContexts.Acquire();
+	TUniquePtr<FSpiderNavSearchContext> BackwardContext = SearchContexts.Acquire();
+
+	// queries share one path buffer like callers of FindPathInto do
+	TArray<int32> Path;
+
+	// Query returns number of expanded nodes
+	auto RunQueries = [&](const TCHAR* Name, TFunctionRef<int32(int32, int32, bool&)> Query) {
+		// the same seed gives the same queries between runs
+		FRandomStream RandomStream(NavGraph.Num());
+
+		int64 ExpandedNodesNum = 0;
+		int32 CompletePathsNum = 0;
+		double StartTime = FPlatformTime::Seconds();
+
+		for (int32 i = 0; i < QueriesNum; i++) {
+			int32 StartIndex = RandomStream.RandHelper(NavGraph.Num());
+			int32 EndIndex = RandomStream.RandHelper(NavGraph.Num());
+			bool bFoundCompletePath = false;
+			ExpandedNodesNum += Query(StartIndex, EndIndex, bFoundCompletePath);
+			if (bFoundCompletePath) {
+				CompletePathsNum++;
+			}
+		}
+
+		double Seconds = FMath::Max(FPlatformTime::Seconds() - StartTime, SMALL_NUMBER);
+
+		float ExpandedPerSecond = ExpandedNodesNum / Seconds;
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("Benchmark (%s): queries = %d, complete = %d, time = %f ms, expanded per query = %f, expanded per second = %f"),
+			Name, QueriesNum, CompletePathsNum, Seconds * 1000.0, (double)ExpandedNodesNum / QueriesNum, ExpandedPerSecond);
+
+		return ExpandedPerSecond;
+	};
+
+	auto AStarQuery = [&](bool bAllowLandmarks) {
+		return [&, bAllowLandmarks](int32 StartIndex, int32 EndIndex, bool& bFoundCompletePath) {
+			FindNodesPath(NavGraph, *Context, StartIndex, EndIndex, Path, bFoundCompletePath, nullptr, bAllowLandmarks);
+			return Context->ExpandedNodesNum;
+		};
+	};
+
+	const bool bUseLandmarks = HeuristicMode == ESpiderNavHeuristic::Landmarks && !NavGraph.Landmarks.IsEmpty();
+	float ExpandedPerSecond = RunQueries(TEXT("euclidean"), AStarQuery(false));
+	if (bUseLandmarks) {
+		ExpandedPerSecond = RunQueries(TEXT("landmarks"), AStarQuery(true));
+	}
+
+	if (SearchMode == ESpiderNavSearchMode::Bidirectional) {
+		ExpandedPerSecond = RunQueries(bUseLandmarks ? TEXT("bidirectional, landmarks") : TEXT("bidirectional, euclidean"), [&](int32 StartIndex, int32 EndIndex, bool& bFoundCompletePath) {
+			bFoundCompletePath = FindNodesPathBidirectional(NavGraph, *Context, *BackwardContext, StartIndex, EndIndex, Path);
+			return Context->ExpandedNodesNum + BackwardContext->ExpandedNodesNum;
+		});
+	}
+
+	SearchContexts.Release(MoveTemp(BackwardContext));
+	SearchContexts.Release(MoveTemp(Context));
+
+	return ExpandedPerSecond;
+}
+
+int32 ASpiderNavigation::FindClosestNode(const FSpiderNavGraph& NavGraph, FVector Location) const
 {
-	Super::Tick(DeltaTime);
+	return NavGraph.SpatialIndex.FindClosest(Location);
 }
 
-void ASpiderNavigation::AddGridNode(int32 SavedIndex, FVector Location, FVector Normal)
+void ASpiderNavigation::FindClosestNodes(const FSpiderNavGraph& NavGraph, const TArray<FVector>& Locations, TArray<int32>& OutIndexes) const
 {
-	FSpiderNavNode NavNode;
-	NavNode.Location = Location;
-	NavNode.Normal = Normal;
+	NavGraph.SpatialIndex.FindClosest(Locations, OutIndexes);
+}
 
-	int32 Index = NavNodes.Add(NavNode);
-	NavNodes[Index].Index = Index;
+int32 ASpiderNavigation::FindClosestNode(const FSpiderNavGraph& NavGraph, FVector Location, FSpiderNavLocationHandle& Handle) const
+{
+	// node of handle from another grid means nothing unless it is kept in grid stitched from that one
+	const bool bValidHint = Handle.GraphId == NavGraph.Id || (Handle.GraphId == NavGraph.PreviousId && NavGraph.IsNodeKept(Handle.NodeIndex));
+	const int32 HintIndex = bValidHint ? Handle.NodeIndex : INDEX_NONE;
+	Handle.NodeIndex = NavGraph.FindClosestNodeFromHint(HintIndex, Location);
+	Handle.GraphId = NavGraph.Id;
 
-	NodesSavedIndexes.Add(SavedIndex, Index);
+	return Handle.NodeIndex;
 }
 
-void ASpiderNavigation::SetGridNodeNeighbors(int32 SavedIndex, TArray<int32> NeighborsSavedIndexes)
+void ASpiderNavigation::BuildNodesPathFromEndNode(const FSpiderNavSearchContext& Context, int32 EndIndex, TArray<int32>& OutPath)
 {
-	int32* Index = NodesSavedIndexes.Find(SavedIndex);
-	if (Index) {
-		FSpiderNavNode* NavNode =  &(NavNodes[*Index]);
-		for (int32 i = 0; i != NeighborsSavedIndexes.Num(); ++i) {
-			 int32* NeighborIndex = NodesSavedIndexes.Find(NeighborsSavedIndexes[i]);
-			 if (NeighborIndex) {
-				 FSpiderNavNode* NeighborNode = &(NavNodes[*NeighborIndex]);
-				 NavNode->Neighbors.Add(NeighborNode);
-			 }
-		}
+	// length is counted first, so nodes are written in place from the end without growing and reversing the array
+	int32 PathLength = 1;
+	const FSpiderNavSearchNode* IterNode = Context.FindNode(EndIndex);
+	while (IterNode && IterNode->ParentIndex > -1) {
+		PathLength++;
+		IterNode = Context.FindNode(IterNode->ParentIndex);
+	}
+
+	OutPath.SetNumUninitialized(PathLength, false);
+	int32 NodeIndex = EndIndex;
+	for (int32 i = PathLength - 1; i >= 0; i--) {
+		OutPath[i] = NodeIndex;
+		IterNode = Context.FindNode(NodeIndex);
+		NodeIndex = IterNode ? IterNode->ParentIndex : INDEX_NONE;
 	}
 }
 
-int32 ASpiderNavigation::GetNavNodesCount()
+bool ASpiderNavigation::LoadGrid()
 {
-	return NavNodes.Num();
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("Start loading Spider nav data"));
+	EmptyGrid();
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("After empty grid"));
+
+	// asynchronous loading which is still running would replace this grid
+	GridLoadId++;
+	bGridReady = false;
+
+	FSpiderNavGridData GridData;
+	if (LoadGridDataFromAsset(GridData)) {
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("After reading grid asset %s"), *GridAsset.ToString());
+	} else if (GridData.LoadFromFile(FSpiderNavGridData::GetDefaultFilename())) {
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("After reading binary grid"));
+	} else if (LoadGridDataFromSaveGame(GridData)) {
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("After reading grid from save game"));
+	} else {
+		bGridReady = true;
+		OnGridReady.Broadcast(false);
+		return false;
+	}
+
+	const FSpiderNavBuildSettings Settings = GetBuildSettings();
+	if (Settings.bStreamTiles) {
+		// grid is ready when the first grid of tiles is swapped in
+		SetStreamingTiles(BuildTiles(MoveTemp(GridData), Settings));
+		UpdateStreaming(true);
+	} else {
+		SetGraph(BuildGraph(MoveTemp(GridData), Settings));
+		bGridReady = true;
+		OnGridReady.Broadcast(true);
+	}
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("Nav Nodes Loaded: %d"), GetNavNodesCount());
+
+	return true;
 }
 
-TArray<FVector> ASpiderNavigation::FindPath(FVector Start, FVector End, bool& bFoundCompletePath)
+void ASpiderNavigation::LoadGridAsync()
 {
-	TArray<FVector> Path;
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("Start loading Spider nav data on worker thread"));
+	bGridReady = false;
+	++GridLoadId;
+
+	if (!GridAsset.IsNull()) {
+		// package of asset is loaded by the async loading thread, then grid is copied from it on a worker thread
+		GridAssetHandle = StreamableManager.RequestAsyncLoad(GridAsset.ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &ASpiderNavigation::OnGridAssetLoaded, GridLoadId));
+		return;
+	}
 
-	FSpiderNavNode* StartNode = FindClosestNode(Start);
-	FSpiderNavNode* EndNode = FindClosestNode(End);
-	TArray<FSpiderNavNode*> NodesPath = FindNodesPath(StartNode, EndNode, bFoundCompletePath);
+	BuildGraphAsync(GridLoadId, nullptr);
+}
 
-	for (int32 i = 0; i < NodesPath.Num(); i++) {
-		FSpiderNavNode* Node = NodesPath[i];
-		Path.Add(Node->Location);
+void ASpiderNavigation::OnGridAssetLoaded(int32 LoadId)
+{
+	if (LoadId != GridLoadId) {
+		return;
 	}
 
-	return Path;
+	// the handle goes to the worker, so the asset is kept loaded until its grid is copied there
+	TSharedPtr<FStreamableHandle> AssetHandle = GridAssetHandle;
+	GridAssetHandle.Reset();
+
+	const USpiderNavGridAsset* Asset = AssetHandle.IsValid() ? Cast<USpiderNavGridAsset>(AssetHandle->GetLoadedAsset()) : nullptr;
+	if (Asset && Asset->GridData.Locations.Num()) {
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("After loading grid asset %s"), *GridAsset.ToString());
+		BuildGraphAsync(LoadId, nullptr, Asset, AssetHandle);
+	} else {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Grid asset %s has no grid"), *GridAsset.ToString());
+		BuildGraphAsync(LoadId, nullptr);
+	}
 }
 
-TArray<FSpiderNavNode*> ASpiderNavigation::FindNodesPath(FSpiderNavNode* StartNode, FSpiderNavNode* EndNode, bool& bFoundCompletePath)
+bool ASpiderNavigation::IsGridReady() const
 {
-	TArray<FSpiderNavNode*> Path;
-	FSpiderNavNode* Node = NULL;
-	TArray <FSpiderNavNode*> Neighbors;
+	return bGridReady;
+}
 
-	if (!StartNode || !EndNode) {
-		//GEngine->AddOnScreenDebugMessage(0, 1.0f, FColor::Yellow, TEXT("Not found closest nodes"));
-		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Not found closest nodes"));
-		return Path;
+bool ASpiderNavigation::CheckGridReady(const TCHAR* QueryName) const
+{
+	// queries are made every frame while the grid is loading, so it is not a warning
+	if (!bGridReady) {
+		UE_LOG(SpiderNAV_LOG, Verbose, TEXT("%s: grid is not ready"), QueryName);
 	}
+	return bGridReady;
+}
 
+void ASpiderNavigation::BuildGraphAsync(int32 LoadId, TSharedPtr<FSpiderNavGridData, ESPMode::ThreadSafe> GridData, const USpiderNavGridAsset* Asset, TSharedPtr<FStreamableHandle> AssetHandle)
+{
+	TWeakObjectPtr<ASpiderNavigation> WeakThis(this);
+	const FSpiderNavBuildSettings Settings = GetBuildSettings();
+
+	// counted as a query, so the actor is not destroyed while the worker runs
+	PendingQueriesNum.Increment();
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [this, WeakThis, LoadId, GridData, Asset, AssetHandle, Settings]() mutable {
+		const bool bFromGameThread = GridData.IsValid() || Asset;
+		FSpiderNavGridData OwnGridData;
+		FSpiderNavGridData* LoadedGridData = nullptr;
+		if (GridData.IsValid()) {
+			LoadedGridData = GridData.Get();
+		} else if (Asset) {
+			// the asset may be used by another actor or loaded again, so its grid is copied instead of moved
+			OwnGridData = Asset->GridData;
+			LoadedGridData = &OwnGridData;
+		} else if (OwnGridData.LoadFromFile(FSpiderNavGridData::GetDefaultFilename())) {
+			LoadedGridData = &OwnGridData;
+		}
 
-	ResetGridMetrics();
-	//OpenList.Empty();
-	std::vector<FSpiderNavNode*> openList;
-	TArray<FSpiderNavNode*> ClosedList;
-
-	//OpenList.Add(StartNode);
-	openList.push_back(StartNode);
-	std::make_heap(openList.begin(), openList.end(), LessThanByNodeF());
-	StartNode->Opened = true;
+		// streamed grid is built on the game thread's request when it knows where players are
+		FSpiderNavGraphPtr NewGraph;
+		FSpiderNavTilesPtr NewTiles;
+		if (LoadedGridData && Settings.bStreamTiles) {
+			NewTiles = BuildTiles(MoveTemp(*LoadedGridData), Settings);
+		} else if (LoadedGridData) {
+			NewGraph = BuildGraph(MoveTemp(*LoadedGridData), Settings);
+		}
 
+		// the handle is released on the game thread like it has been acquired
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, LoadId, NewGraph, NewTiles, bFromGameThread, AssetHandle = MoveTemp(AssetHandle)]() mutable {
+			AssetHandle.Reset();
+			if (ASpiderNavigation* Navigation = WeakThis.Get()) {
+				Navigation->FinishGridLoading(LoadId, NewGraph, NewTiles, bFromGameThread);
+			}
+		});
+		PendingQueriesNum.Decrement();
+	});
+}
 
-	while (openList.size()) {
-		//Node = GetFromOpenList();
-		std::pop_heap(openList.begin(), openList.end(), LessThanByNodeF());
-		Node = openList.back();
-		openList.pop_back();
+void ASpiderNavigation::FinishGridLoading(int32 LoadId, FSpiderNavGraphPtr NewGraph, FSpiderNavTilesPtr NewTiles, bool bFromGameThread)
+{
+	if (LoadId != GridLoadId) {
+		return;
+	}
 
-		Node->Closed = true;
-		if (Node != StartNode) {
-			ClosedList.Add(Node);
+	const bool bLoaded = NewGraph.IsValid() || NewTiles.IsValid();
+	if (!bLoaded && !bFromGameThread) {
+		// save game is an object, so it is read on the game thread, but the grid is still built on worker thread
+		TSharedPtr<FSpiderNavGridData, ESPMode::ThreadSafe> GridData = MakeShared<FSpiderNavGridData, ESPMode::ThreadSafe>();
+		if (LoadGridDataFromSaveGame(*GridData)) {
+			BuildGraphAsync(LoadId, GridData);
+			return;
 		}
+	}
 
-		if (Node->Index == EndNode->Index) {
-			bFoundCompletePath = true;
-			return BuildNodesPathFromEndNode(Node);
-		}
+	// builds of streamed grid started before loading have been dropped
+	bStreamingInProgress = false;
+	if (NewTiles.IsValid()) {
+		// grid is not ready until grid of tiles around players is built, FinishStreaming tells that it is ready then
+		SetStreamingTiles(NewTiles);
+		UpdateStreaming(false);
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("Nav Tiles Loaded: %d"), NewTiles->Num());
+		return;
+	}
+
+	bGridReady = true;
+	if (NewGraph.IsValid()) {
+		SetStreamingTiles(nullptr);
+		SetGraph(NewGraph);
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("Nav Nodes Loaded: %d"), GetNavNodesCount());
+	}
+	OnGridReady.Broadcast(bLoaded);
+}
 
-		for (FSpiderNavNode* Neighbor : Node->Neighbors) {
+bool ASpiderNavigation::LoadGridDataFromAsset(FSpiderNavGridData& OutGridData)
+{
+	if (GridAsset.IsNull()) {
+		return false;
+	}
 
-			if (Neighbor->Closed) {
-				continue;
-			}
+	// the asset may be used by another actor or loaded again, so its grid is copied instead of moved
+	const USpiderNavGridAsset* Asset = GridAsset.LoadSynchronous();
+	if (!Asset || !Asset->GridData.Locations.Num()) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Grid asset %s has no grid"), *GridAsset.ToString());
+		return false;
+	}
 
-			//DrawDebugString(GetWorld(), Neighbor->Location, *FString::Printf(TEXT("[%d]"), Neighbor->Neighbors.Num()), NULL, FLinearColor(0.0f, 1.0f, 0.0f, 1.0f).ToFColor(true), 20.0f, false);
+	OutGridData = Asset->GridData;
+	return true;
+}
 
-			// get the distance between current node and the neighbor
-			// and calculate the next g score
-			float NewG = Node->G + (Neighbor->Location - Node->Location).Size();
+bool ASpiderNavigation::LoadGridDataFromSaveGame(FSpiderNavGridData& OutGridData) const
+{
+	USpiderNavGridSaveGame* LoadGameInstance = Cast<USpiderNavGridSaveGame>(UGameplayStatics::CreateSaveGameObject(USpiderNavGridSaveGame::StaticClass()));
+	LoadGameInstance = Cast<USpiderNavGridSaveGame>(UGameplayStatics::LoadGameFromSlot(LoadGameInstance->SaveSlotName, LoadGameInstance->UserIndex));
+	if (!LoadGameInstance) {
+		return false;
+	}
 
-			// check if the neighbor has not been inspected yet, or
-			// can be reached with smaller cost from the current node
-			if (!Neighbor->Opened || NewG < Neighbor->G) {
-				Neighbor->G = NewG;
-				Neighbor->H = (Neighbor->Location - EndNode->Location).Size();
-				Neighbor->F = Neighbor->G + Neighbor->H;
-				Neighbor->ParentIndex = Node->Index;
-
-				if (!Neighbor->Opened) {
-					//OpenList.Add(Neighbor);
-					openList.push_back(Neighbor);
-					std::push_heap(openList.begin(), openList.end(), LessThanByNodeF());
-					Neighbor->Opened = true;
-				} else {
-					// the neighbor can be reached with smaller cost.
-					// Since its f value has been updated, we have to
-					// update its position in the open list
-					std::make_heap(openList.begin(), openList.end(), LessThanByNodeF());
+	// SavedIndex -> LocalIndex
+	TMap<int32, int32> NodesSavedIndexes;
+	TArray<int32> SavedIndexes;
+	const int32 NodesNum = LoadGameInstance->NavLocations.Num();
+	NodesSavedIndexes.Reserve(NodesNum);
+	SavedIndexes.Reserve(NodesNum);
+	OutGridData.Locations.Reserve(NodesNum);
+	OutGridData.Normals.Reserve(NodesNum);
+	OutGridData.GridStepSize = LoadGameInstance->GridStepSize;
+
+	for (auto It = LoadGameInstance->NavLocations.CreateConstIterator(); It; ++It) {
+		FVector* NormalRef = LoadGameInstance->NavNormals.Find(It.Key());
+		NodesSavedIndexes.Add(It.Key(), OutGridData.Locations.Add(It.Value()));
+		SavedIndexes.Add(It.Key());
+		OutGridData.Normals.Add(NormalRef ? *NormalRef : FVector(0.0f, 0.0f, 1.0f));
+	}
+
+	// nodes are visited in local order, so edges come out grouped into rows
+	OutGridData.EdgeOffsets.Reserve(NodesNum + 1);
+	OutGridData.EdgeOffsets.Add(0);
+	for (int32 i = 0; i < NodesNum; i++) {
+		if (const FSpiderNavRelations* Relations = LoadGameInstance->NavRelations.Find(SavedIndexes[i])) {
+			for (int32 NeighborSavedIndex : Relations->Neighbors) {
+				if (int32* NeighborIndex = NodesSavedIndexes.Find(NeighborSavedIndex)) {
+					OutGridData.EdgeTargets.Add(*NeighborIndex);
 				}
 			}
 		}
+		OutGridData.EdgeOffsets.Add(OutGridData.EdgeTargets.Num());
 	}
 
-	UE_LOG(SpiderNAV_LOG, Warning, TEXT("Not found complete path"));
-
+	if (LoadGameInstance->NavClusters.Num() == NodesNum) {
+		OutGridData.ClusterIds.SetNumUninitialized(NodesNum);
+		for (auto It = LoadGameInstance->NavClusters.CreateConstIterator(); It; ++It) {
+			int32* Index = NodesSavedIndexes.Find(It.Key());
+			if (!Index) {
+				OutGridData.ClusterIds.Reset();
+				break;
+			}
+			OutGridData.ClusterIds[*Index] = It.Value();
+		}
 
-	//Finding closest to end
-	float IterMin = 99999999999.0f;
-	for (FSpiderNavNode* IterNode : ClosedList) {
-		if (IterNode->F < IterMin) {
-			IterMin = IterNode->F;
-			Node = IterNode;
+		if (OutGridData.ClusterIds.Num()) {
+			OutGridData.AbstractEdges.Reserve(LoadGameInstance->NavAbstractEdges.Num());
+			for (const FSpiderNavAbstractEdge& SavedEdge : LoadGameInstance->NavAbstractEdges) {
+				int32* From = NodesSavedIndexes.Find(SavedEdge.From);
+				int32* To = NodesSavedIndexes.Find(SavedEdge.To);
+				if (From && To) {
+					OutGridData.AbstractEdges.Emplace(*From, *To, SavedEdge.Cost);
+				}
+			}
 		}
-		//DrawDebugString(GetWorld(), closedList[i]->Location, *FString::Printf(TEXT("[%f, %f]"), closedList[i]->F, closedList[i]->H), NULL, FLinearColor(0.0f, 1.0f, 0.0f, 1.0f).ToFColor(true), DebugLinesThickness, false);
 	}
 
-	if (Node) {
-		UE_LOG(SpiderNAV_LOG, Log, TEXT("Min F = %f"), Node->F);
-		bFoundCompletePath = false;
-		//DrawDebugString(GetWorld(), Node->Location, *FString::Printf(TEXT("MINH[%f]"), Node->H), NULL, FLinearColor(1.0f, 0.0f, 0.0f, 1.0f).ToFColor(true), DebugLinesThickness, false);
+	if (LoadGameInstance->NavRanks.Num() == NodesNum) {
+		OutGridData.Ranks.SetNumUninitialized(NodesNum);
+		for (auto It = LoadGameInstance->NavRanks.CreateConstIterator(); It; ++It) {
+			int32* Index = NodesSavedIndexes.Find(It.Key());
+			if (!Index) {
+				OutGridData.Ranks.Reset();
+				break;
+			}
+			OutGridData.Ranks[*Index] = It.Value();
+		}
 
-		return BuildNodesPathFromEndNode(Node);
+		if (OutGridData.Ranks.Num()) {
+			OutGridData.HierarchyEdges.Reserve(LoadGameInstance->NavHierarchyEdges.Num());
+			for (const FSpiderNavHierarchyEdge& SavedEdge : LoadGameInstance->NavHierarchyEdges) {
+				int32* From = NodesSavedIndexes.Find(SavedEdge.From);
+				int32* To = NodesSavedIndexes.Find(SavedEdge.To);
+				int32* Middle = NodesSavedIndexes.Find(SavedEdge.Middle);
+				if (From && To) {
+					OutGridData.HierarchyEdges.Emplace(*From, *To, SavedEdge.Cost, Middle ? *Middle : INDEX_NONE);
+				}
+			}
+		}
 	}
 
+	return true;
+}
 
-	return Path;
+FSpiderNavBuildSettings ASpiderNavigation::GetBuildSettings() const
+{
+	FSpiderNavBuildSettings Settings;
+	Settings.bStreamTiles = bStreamTiles;
+	Settings.StreamingTileSize = StreamingTileSize;
+	Settings.StreamingMemoryBudgetMB = StreamingMemoryBudgetMB;
+	Settings.SearchMode = SearchMode;
+	Settings.HeuristicMode = HeuristicMode;
+	Settings.LandmarksNum = LandmarksNum;
+	Settings.StorageMode = StorageMode;
+	Settings.QuantizationStep = QuantizationStep;
+	return Settings;
 }
 
-FSpiderNavNode* ASpiderNavigation::GetFromOpenList()
+FSpiderNavGraphPtr ASpiderNavigation::BuildGraph(FSpiderNavGridData&& GridData, const FSpiderNavBuildSettings& Settings)
 {
-	float MinF = 9999999999.0f;
-	FSpiderNavNode* MinNode = NULL;
-	for (FSpiderNavNode* Node : OpenList) {
-		if (Node->F < MinF) {
-			MinF = Node->F;
-			MinNode = Node;
-		}
+	TSharedRef<FSpiderNavGraph, ESPMode::ThreadSafe> NewGraph = MakeShared<FSpiderNavGraph, ESPMode::ThreadSafe>();
+	NewGraph->BuildFromRows(MoveTemp(GridData.Locations), MoveTemp(GridData.Normals), MoveTemp(GridData.EdgeOffsets), MoveTemp(GridData.EdgeTargets), GridData.GridStepSize);
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("After building graph"));
+
+	if (GridData.ClusterIds.Num() == NewGraph->Num()) {
+		NewGraph->Clusters.Build(MoveTemp(GridData.ClusterIds), GridData.AbstractEdges);
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("After building clusters"));
+	} else if (Settings.SearchMode == ESpiderNavSearchMode::Hierarchical) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Grid has been saved without clusters, hierarchical search falls back to A-star"));
 	}
-	if (MinNode) {
-		OpenList.Remove(MinNode);
+
+	if (GridData.Ranks.Num() == NewGraph->Num()) {
+		NewGraph->ContractionHierarchy.Build(MoveTemp(GridData.Ranks), GridData.HierarchyEdges);
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("After building contraction hierarchy"));
+	} else if (Settings.SearchMode == ESpiderNavSearchMode::ContractionHierarchy) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Grid has been saved without contraction hierarchy, search falls back to A-star"));
 	}
 
-	return MinNode;
-}
+	if (Settings.HeuristicMode == ESpiderNavHeuristic::Landmarks && Settings.LandmarksNum > 0) {
+		NewGraph->Landmarks.Build(*NewGraph, Settings.LandmarksNum);
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("After computing %d landmarks, memory = %d bytes"), NewGraph->Landmarks.Num(), NewGraph->Landmarks.GetAllocatedSize());
+	}
 
-FSpiderNavNode* ASpiderNavigation::FindClosestNode(FVector Location)
-{
-	FSpiderNavNode* ClosestNode = nullptr;
-	float MinDistance = 999999999;
-	for (int32 i = 0; i != NavNodes.Num(); i++) {
-		float Distance = (NavNodes[i].Location - Location).Size();
-		if (Distance < MinDistance) {
-			MinDistance = Distance;
-			ClosestNode = &(NavNodes[i]);
+	if (Settings.StorageMode == ESpiderNavStorageMode::Quantized) {
+		if (NewGraph->Quantize(Settings.QuantizationStep)) {
+			UE_LOG(SpiderNAV_LOG, Log, TEXT("After quantizing, tiles = %d"), NewGraph->TileOrigins.Num());
+		} else {
+			UE_LOG(SpiderNAV_LOG, Warning, TEXT("Grid can not be quantized with step %f, full precision is kept"), Settings.QuantizationStep);
 		}
 	}
 
-	return ClosestNode;
+	const SIZE_T GraphSize = NewGraph->GetAllocatedSize();
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("Grid memory = %llu bytes, per node = %f bytes"), (uint64)GraphSize, NewGraph->Num() > 0 ? (float)GraphSize / NewGraph->Num() : 0.0f);
+
+	return NewGraph;
 }
 
-void ASpiderNavigation::ResetGridMetrics()
+FSpiderNavGraphPtr ASpiderNavigation::BuildStreamedGraph(FSpiderNavTilesPtr Tiles, const TArray<int32>& TileIndexes, FSpiderNavGraphPtr PreviousGraph, const FSpiderNavBuildSettings& Settings)
 {
-	for (int32 i = 0; i != NavNodes.Num(); ++i) {
-		FSpiderNavNode Node = NavNodes[i];
-		Node.ResetMetrics();
-		NavNodes[i] = Node;
+	TSharedRef<FSpiderNavGraph, ESPMode::ThreadSafe> NewGraph = MakeShared<FSpiderNavGraph, ESPMode::ThreadSafe>();
+	const bool bQuantize = Settings.StorageMode == ESpiderNavStorageMode::Quantized;
+	NewGraph->BuildFromTiles(Tiles, TileIndexes, PreviousGraph.Get(), bQuantize);
+	if (bQuantize && NewGraph->Num() > 0 && !NewGraph->IsQuantized()) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Too many tiles are streamed in to quantize grid, full precision is kept"));
 	}
+
+	const SIZE_T GraphSize = NewGraph->GetAllocatedSize();
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("Grid memory = %llu bytes, nodes = %d, kept nodes = %d"), (uint64)GraphSize, NewGraph->Num(), NewGraph->KeptNodes.CountSetBits());
+
+	return NewGraph;
 }
 
-TArray<FVector> ASpiderNavigation::BuildPathFromEndNode(FSpiderNavNode* EndNode)
+void ASpiderNavigation::SetGraph(FSpiderNavGraphPtr NewGraph)
 {
-	TArray<FVector> Path;
-	TArray<int32> ReversedPathIndexes;
-
-	ReversedPathIndexes.Add(EndNode->Index);
+	// queries on worker threads keep the old grid until they finish
+	Graph = NewGraph;
+	SearchContexts.Empty();
+	AbstractSearchContexts.Empty();
+	PathCache.SetCapacity(PathCacheSize);
+	PathCache.Invalidate(Graph->Id);
+	AgentPlanners.Empty();
+	PathRequestsNum = 0;
+	MergedPathRequestsNum = 0;
+
+	FScopeLock ScopeLock(&FlowFieldsLock);
+	FlowFields.Empty();
+}
 
-	FSpiderNavNode* IterNode = EndNode;
-	while (IterNode->ParentIndex > -1) {
-		ReversedPathIndexes.Add(IterNode->ParentIndex);
-		IterNode = &NavNodes[IterNode->ParentIndex];
+void ASpiderNavigation::SwapStreamedGraph(FSpiderNavGraphPtr NewGraph)
+{
+	// nodes of tiles which stay streamed in keep their indexes and edges, so paths, searches and flow fields over them stay valid
+	Graph = NewGraph;
+	const FSpiderNavGraph& NavGraph = *NewGraph;
+	auto IsNodeKept = [&NavGraph](int32 Node) {
+		return NavGraph.IsNodeKept(Node);
+	};
+
+	PathCache.Rebase(NavGraph.PreviousId, NavGraph.Id, IsNodeKept);
+	for (auto It = AgentPlanners.CreateIterator(); It; ++It) {
+		It.Value()->Rebase(NavGraph.PreviousId, NavGraph.Id, IsNodeKept);
 	}
 
-	for (int32 i = ReversedPathIndexes.Num() - 1; i > -1; i--) {
-		int32 Index = ReversedPathIndexes[i];
-		Path.Add(NavNodes[Index].Location);
+	FScopeLock ScopeLock(&FlowFieldsLock);
+	for (int32 i = FlowFields.Num() - 1; i >= 0; i--) {
+		if (!FlowFields[i]->Rebase(NavGraph.PreviousId, NavGraph.Id, IsNodeKept)) {
+			FlowFields.RemoveAt(i, 1, false);
+		}
 	}
+}
 
-	return Path;
+void ASpiderNavigation::EmptyGrid()
+{
+	SetStreamingTiles(nullptr);
+	SetGraph(MakeShared<FSpiderNavGraph, ESPMode::ThreadSafe>());
 }
 
-TArray<FSpiderNavNode*> ASpiderNavigation::BuildNodesPathFromEndNode(FSpiderNavNode* EndNode)
+FSpiderNavTilesPtr ASpiderNavigation::BuildTiles(FSpiderNavGridData&& GridData, const FSpiderNavBuildSettings& Settings)
 {
-	TArray<FSpiderNavNode*> Path;
-	TArray<int32> ReversedPathIndexes;
+	TSharedRef<FSpiderNavTiles, ESPMode::ThreadSafe> NewTiles = MakeShared<FSpiderNavTiles, ESPMode::ThreadSafe>();
+	NewTiles->Build(MoveTemp(GridData), Settings.StreamingTileSize);
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("After splitting grid into %d tiles"), NewTiles->Num());
 
-	ReversedPathIndexes.Add(EndNode->Index);
+	if (Settings.HeuristicMode == ESpiderNavHeuristic::Landmarks && Settings.LandmarksNum > 0) {
+		NewTiles->BuildLandmarks(Settings.LandmarksNum);
+		UE_LOG(SpiderNAV_LOG, Log, TEXT("After computing %d landmarks of the whole grid, memory = %d bytes"), NewTiles->Landmarks.Num(), NewTiles->Landmarks.GetAllocatedSize());
+	}
 
-	FSpiderNavNode* IterNode = EndNode;
-	while (IterNode->ParentIndex > -1) {
-		ReversedPathIndexes.Add(IterNode->ParentIndex);
-		IterNode = &NavNodes[IterNode->ParentIndex];
+	if (Settings.SearchMode == ESpiderNavSearchMode::Hierarchical || Settings.SearchMode == ESpiderNavSearchMode::ContractionHierarchy) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Clusters and contraction hierarchy are not used for streamed grid, search falls back to A-star"));
 	}
 
-	for (int32 i = ReversedPathIndexes.Num() - 1; i > -1; i--) {
-		int32 Index = ReversedPathIndexes[i];
-		Path.Add(&NavNodes[Index]);
+	const SIZE_T TilesSize = NewTiles->GetAllocatedSize();
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("Tiles memory = %llu bytes, per node = %f bytes"), (uint64)TilesSize, NewTiles->Locations.Num() > 0 ? (float)TilesSize / NewTiles->Locations.Num() : 0.0f);
+	if (TilesSize > Settings.StreamingMemoryBudgetMB * 1024.0f * 1024.0f) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("Tiles take more than StreamingMemoryBudgetMB, only the closest tile is streamed in"));
 	}
 
-	return Path;
+	return NewTiles;
 }
 
-bool ASpiderNavigation::LoadGrid()
+void ASpiderNavigation::SetStreamingTiles(FSpiderNavTilesPtr Tiles)
 {
-	UE_LOG(SpiderNAV_LOG, Log, TEXT("Start loading Spider nav data"));
-	EmptyGrid();
-	UE_LOG(SpiderNAV_LOG, Log, TEXT("After empty grid"));
+	StreamingTiles = Tiles;
+	StreamedTiles.Empty();
+	bStreamingInProgress = false;
+	TimeToStreamingUpdate = StreamingUpdateInterval;
 
-	FVector* NormalRef = NULL;
-	FVector Normal;
+	FScopeLock ScopeLock(&RequestedTilesLock);
+	RequestedTiles.Init(0.0, Tiles.IsValid() ? Tiles->Num() : 0);
+}
 
-	USpiderNavGridSaveGame* LoadGameInstance = Cast<USpiderNavGridSaveGame>(UGameplayStatics::CreateSaveGameObject(USpiderNavGridSaveGame::StaticClass()));
-	LoadGameInstance = Cast<USpiderNavGridSaveGame>(UGameplayStatics::LoadGameFromSlot(LoadGameInstance->SaveSlotName, LoadGameInstance->UserIndex));
-	if (LoadGameInstance) {
-		UE_LOG(SpiderNAV_LOG, Log, TEXT("After getting load game instance"));
-		for (auto It = LoadGameInstance->NavLocations.CreateConstIterator(); It; ++It) {
-			NormalRef = LoadGameInstance->NavNormals.Find(It.Key());
-			if (NormalRef) {
-				Normal = *NormalRef;
-			} else {
-				Normal = FVector(0.0f, 0.0f, 1.0f);
+void ASpiderNavigation::UpdateStreaming(bool bSynchronous)
+{
+	if (!StreamingTiles.IsValid() || bStreamingInProgress) {
+		return;
+	}
+
+	TArray<int32> Tiles;
+	ChooseStreamedTiles(Tiles);
+	// the first grid is built even without tiles, so loading is finished
+	if (Tiles == StreamedTiles && bGridReady) {
+		return;
+	}
+
+	// tiles which stay streamed in are copied from the current grid
+	if (bSynchronous) {
+		FinishStreaming(GridLoadId, BuildStreamedGraph(StreamingTiles, Tiles, Graph, GetBuildSettings()), Tiles);
+		return;
+	}
+
+	TWeakObjectPtr<ASpiderNavigation> WeakThis(this);
+	const int32 LoadId = GridLoadId;
+	FSpiderNavTilesPtr SourceTiles = StreamingTiles;
+	FSpiderNavGraphPtr PreviousGraph = Graph;
+	const FSpiderNavBuildSettings Settings = GetBuildSettings();
+
+	bStreamingInProgress = true;
+	PendingQueriesNum.Increment();
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [this, WeakThis, LoadId, SourceTiles, PreviousGraph, Tiles, Settings]() {
+		FSpiderNavGraphPtr NewGraph = BuildStreamedGraph(SourceTiles, Tiles, PreviousGraph, Settings);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, LoadId, NewGraph, Tiles]() {
+			if (ASpiderNavigation* Navigation = WeakThis.Get()) {
+				Navigation->FinishStreaming(LoadId, NewGraph, Tiles);
 			}
-			AddGridNode(It.Key(), It.Value(), Normal);
+		});
+		PendingQueriesNum.Decrement();
+	});
+}
+
+void ASpiderNavigation::ChooseStreamedTiles(TArray<int32>& OutTiles)
+{
+	OutTiles.Reset();
+	const FSpiderNavTiles& Tiles = *StreamingTiles;
+
+	TArray<FVector> SourceLocations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It) {
+		APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->GetPawn()) {
+			SourceLocations.Add(PlayerController->GetPawn()->GetActorLocation());
 		}
-		UE_LOG(SpiderNAV_LOG, Log, TEXT("After setting locations"));
+	}
+	StreamingSources.RemoveAll([](const TWeakObjectPtr<AActor>& Source) {
+		return !Source.IsValid();
+	});
+	for (const TWeakObjectPtr<AActor>& Source : StreamingSources) {
+		SourceLocations.Add(Source->GetActorLocation());
+	}
 
-		for (auto It = LoadGameInstance->NavRelations.CreateConstIterator(); It; ++It) {
-			SetGridNodeNeighbors(It.Key(), It.Value().Neighbors);
+	TBitArray<> Requested(false, Tiles.Num());
+	{
+		const double Now = FPlatformTime::Seconds();
+		FScopeLock ScopeLock(&RequestedTilesLock);
+		for (int32 Tile = 0; Tile != RequestedTiles.Num(); ++Tile) {
+			Requested[Tile] = RequestedTiles[Tile] > 0.0 && Now - RequestedTiles[Tile] <= StreamingRequestTimeout;
 		}
-		UE_LOG(SpiderNAV_LOG, Log, TEXT("After setting relations"));
+	}
 
-		UE_LOG(SpiderNAV_LOG, Log, TEXT("Nav Nodes Loaded: %d"), GetNavNodesCount());
+	// pairs of squared distance to the closest source and tile
+	TArray<TPair<float, int32>> Candidates;
+	const float RadiusSquared = FMath::Square(StreamingRadius);
+	for (int32 Tile = 0; Tile != Tiles.Num(); ++Tile) {
+		float DistanceSquared = MAX_flt;
+		for (const FVector& Location : SourceLocations) {
+			DistanceSquared = FMath::Min(DistanceSquared, Tiles.GetDistanceSquaredToTile(Tile, Location));
+		}
+		if (DistanceSquared <= RadiusSquared || Requested[Tile]) {
+			Candidates.Emplace(DistanceSquared, Tile);
+		}
+	}
+	Candidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) {
+		return A.Key < B.Key;
+	});
+
+	// tiles are kept in memory all the time, runtime grid takes the rest of budget
+	const float NodesBudget = FMath::Max(StreamingMemoryBudgetMB * 1024.0f * 1024.0f - (float)Tiles.GetAllocatedSize(), 0.0f) / StreamingBytesPerNode;
+	int32 NodesNum = 0;
+	for (const TPair<float, int32>& Candidate : Candidates) {
+		const int32 TileNodesNum = Tiles.GetNodesNum(Candidate.Value);
+		if (OutTiles.Num() && NodesNum + TileNodesNum > NodesBudget) {
+			break;
+		}
+		OutTiles.Add(Candidate.Value);
+		NodesNum += TileNodesNum;
+	}
+	OutTiles.Sort();
+}
+
+void ASpiderNavigation::FinishStreaming(int32 LoadId, FSpiderNavGraphPtr NewGraph, const TArray<int32>& Tiles)
+{
+	if (LoadId != GridLoadId) {
+		return;
+	}
+
+	bStreamingInProgress = false;
+	StreamedTiles = Tiles;
+
+	// grid of the first tiles after loading can not keep anything of the old one, everything is reset only then
+	if (bGridReady && NewGraph->PreviousId == Graph->Id) {
+		SwapStreamedGraph(NewGraph);
+	} else {
+		SetGraph(NewGraph);
+	}
+
+	// nodes left in holes between tiles are counted too, they take memory until the holes are filled
+	int32 StreamedNodesNum = 0;
+	for (int32 Tile : Tiles) {
+		StreamedNodesNum += StreamingTiles->GetNodesNum(Tile);
+	}
+	if (StreamedNodesNum > 0) {
+		StreamingBytesPerNode = (float)NewGraph->GetAllocatedSize() / StreamedNodesNum;
+	}
+	UE_LOG(SpiderNAV_LOG, Log, TEXT("Streamed tiles: %d of %d, nodes: %d"), Tiles.Num(), StreamingTiles->Num(), StreamedNodesNum);
+
+	// queries made before are answered by the grid of tiles only now
+	if (!bGridReady) {
+		bGridReady = true;
+		OnGridReady.Broadcast(true);
+	}
+}
 
+bool ASpiderNavigation::IsLocationStreamedIn(const FSpiderNavGraph& NavGraph, const FVector& Location)
+{
+	const int32 Tile = NavGraph.FindStreamingTile(Location);
+	if (Tile == INDEX_NONE) {
 		return true;
 	}
-	return false;
+
+	// streamed tiles are requested too, so they are not streamed out while queries go there
+	{
+		FScopeLock ScopeLock(&RequestedTilesLock);
+		// grid of old tiles can still serve queries for a moment after loading
+		if (Tile < RequestedTiles.Num()) {
+			RequestedTiles[Tile] = FPlatformTime::Seconds();
+		}
+	}
+	return NavGraph.IsTileStreamedIn(Tile);
 }
 
-void ASpiderNavigation::EmptyGrid()
+void ASpiderNavigation::AddStreamingSource(AActor* Source)
 {
-	NodesSavedIndexes.Empty();
-	NavNodes.Empty();
+	if (Source) {
+		StreamingSources.AddUnique(Source);
+	}
+}
+
+void ASpiderNavigation::RemoveStreamingSource(AActor* Source)
+{
+	StreamingSources.Remove(Source);
+}
+
+void ASpiderNavigation::GetStreamingStats(int32& StreamedTilesNum, int32& TilesNum)
+{
+	StreamedTilesNum = StreamedTiles.Num();
+	TilesNum = StreamingTiles.IsValid() ? StreamingTiles->Num() : 0;
 }
 
 
@@ -330,19 +1736,16 @@ void ASpiderNavigation::DrawDebugRelations()
 	float DrawDuration = 20.0f;
 	bool DrawShadow = false;
 
-	for (int32 i = 0; i != NavNodes.Num(); ++i) {
-		FSpiderNavNode Nav = NavNodes[i];
-
-		
-		//DrawDebugString(GetWorld(), Nav.Location, *FString::Printf(TEXT("[%d]"), Nav.Neighbors.Num()), NULL, DrawColor, DrawDuration, DrawShadow);
+	for (int32 i = 0; i != Graph->Num(); ++i) {
+		const FVector Location = Graph->GetLocation(i);
 
+		//DrawDebugString(GetWorld(), Location, *FString::Printf(TEXT("[%d]"), Graph->GetEdgesEnd(i) - Graph->GetEdgesBegin(i)), NULL, DrawColor, DrawDuration, DrawShadow);
 
-		for (int32 j = 0; j != Nav.Neighbors.Num(); ++j) {
-			FSpiderNavNode* NeighborNav = Nav.Neighbors[j];
+		for (int32 Edge = Graph->GetEdgesBegin(i); Edge != Graph->GetEdgesEnd(i); ++Edge) {
 			DrawDebugLine(
 				GetWorld(),
-				Nav.Location,
-				NeighborNav->Location,
+				Location,
+				Graph->GetLocation(Graph->EdgeTargets[Edge]),
 				DrawColor,
 				false,
 				DrawDuration,
@@ -353,8 +1756,8 @@ void ASpiderNavigation::DrawDebugRelations()
 
 		DrawDebugLine(
 			GetWorld(),
-			Nav.Location,
-			Nav.Location + Nav.Normal * 100.0f,
+			Location,
+			Location + Graph->GetNormal(i) * 100.0f,
 			DrawColorNormal,
 			false,
 			DrawDuration,
@@ -369,43 +1772,277 @@ void ASpiderNavigation::DrawDebugRelations()
 FVector ASpiderNavigation::FindClosestNodeLocation(FVector Location)
 {
 	FVector NodeLocation;
-	FSpiderNavNode* Node = FindClosestNode(Location);
-	if (Node) {
-		NodeLocation = Node->Location;
+	int32 NodeIndex = FindClosestNode(*Graph, Location);
+	if (NodeIndex != INDEX_NONE) {
+		NodeLocation = Graph->GetLocation(NodeIndex);
 	}
 	return NodeLocation;
 }
 
+TArray<FVector> ASpiderNavigation::FindClosestNodesLocations(FVector Location, int32 Count)
+{
+	TArray<FVector> Locations;
+	TArray<int32> ClosestIndexes;
+	Graph->SpatialIndex.FindClosest(Location, Count, ClosestIndexes);
+	for (int32 Index : ClosestIndexes) {
+		Locations.Add(Graph->GetLocation(Index));
+	}
+	return Locations;
+}
+
 FVector ASpiderNavigation::FindClosestNodeNormal(FVector Location)
 {
 	FVector NodeNormal;
-	FSpiderNavNode* Node = FindClosestNode(Location);
-	if (Node) {
-		NodeNormal = Node->Normal;
+	int32 NodeIndex = FindClosestNode(*Graph, Location);
+	if (NodeIndex != INDEX_NONE) {
+		NodeNormal = Graph->GetNormal(NodeIndex);
 	}
 	return NodeNormal;
 }
 
 bool ASpiderNavigation::FindNextLocationAndNormal(FVector CurrentLocation, FVector TargetLocation, FVector& NextLocation, FVector& Normal)
 {
-	FSpiderNavNode* StartNode = FindClosestNode(CurrentLocation);
-	FSpiderNavNode* EndNode = FindClosestNode(TargetLocation);
+	if (!CheckGridReady(TEXT("FindNextLocationAndNormal"))) {
+		return false;
+	}
+
+	int32 NextIndex;
+	if (!FindNextNode(*Graph, CurrentLocation, TargetLocation, NextIndex)) {
+		return false;
+	}
+
+	NextLocation = Graph->GetLocation(NextIndex);
+	Normal = Graph->GetNormal(NextIndex);
+
+	return true;
+}
+
+bool ASpiderNavigation::FindNextLocationAndNormalForAgent(AActor* Agent, FVector CurrentLocation, FVector TargetLocation, FVector& NextLocation, FVector& Normal)
+{
+	if (!CheckGridReady(TEXT("FindNextLocationAndNormalForAgent"))) {
+		return false;
+	}
+
+	if (!Agent) {
+		return FindNextLocationAndNormal(CurrentLocation, TargetLocation, NextLocation, Normal);
+	}
+
+	TUniquePtr<FSpiderNavIncrementalPlanner>* Planner = AgentPlanners.Find(Agent);
+	if (!Planner) {
+		// forget destroyed agents before adding a new one
+		for (auto It = AgentPlanners.CreateIterator(); It; ++It) {
+			if (!It.Key().IsValid()) {
+				It.RemoveCurrent();
+			}
+		}
+		Planner = &AgentPlanners.Add(Agent, MakeUnique<FSpiderNavIncrementalPlanner>());
+	}
+
+	const FSpiderNavGraph& NavGraph = *Graph;
+	const int32 StartIndex = FindClosestNode(NavGraph, CurrentLocation);
+	const int32 EndIndex = FindClosestNode(NavGraph, TargetLocation);
+	int32 NextIndex = INDEX_NONE;
+	if (StartIndex != INDEX_NONE && EndIndex != INDEX_NONE && NavGraph.IsReachable(StartIndex, EndIndex)) {
+		NextIndex = (*Planner)->FindNextNode(NavGraph, StartIndex, EndIndex, AgentPlannerMaxNodesNum);
+	}
+
+	if (NextIndex == INDEX_NONE && StartIndex != EndIndex) {
+		// end is not reachable, usual search gives partial path
+		FindNextNode(NavGraph, CurrentLocation, TargetLocation, NextIndex);
+	}
+
+	if (NextIndex == INDEX_NONE) {
+		return false;
+	}
+
+	NextLocation = NavGraph.GetLocation(NextIndex);
+	Normal = NavGraph.GetNormal(NextIndex);
+
+	return true;
+}
+
+void ASpiderNavigation::ForgetAgent(AActor* Agent)
+{
+	AgentPlanners.Remove(Agent);
+}
+
+bool ASpiderNavigation::FindNextNode(const FSpiderNavGraph& NavGraph, FVector CurrentLocation, FVector TargetLocation, int32& NextIndex)
+{
+	int32 StartIndex = FindClosestNode(NavGraph, CurrentLocation);
+	int32 EndIndex = FindClosestNode(NavGraph, TargetLocation);
 	bool bFoundPartialPath;
 
-	FSpiderNavNode* NextNode = NULL;
+	NextIndex = INDEX_NONE;
+
+	if (bUseFlowFields && StartIndex != INDEX_NONE && EndIndex != INDEX_NONE) {
+		if (StartIndex == EndIndex) {
+			return false;
+		}
+		NextIndex = FindNextNodeByFlowField(NavGraph, StartIndex, EndIndex);
+		if (NextIndex != INDEX_NONE) {
+			return true;
+		}
+	}
 
-	TArray<FSpiderNavNode*> NodesPath = FindNodesPath(StartNode, EndNode, bFoundPartialPath);
+	TArray<int32> NodesPath;
+	FindNodesPath(NavGraph, StartIndex, EndIndex, NodesPath, bFoundPartialPath);
 	
 	if (NodesPath.Num() > 1) {
-		NextNode = NodesPath[1];
+		NextIndex = NodesPath[1];
 	}
 
-	if (!NextNode) {
-		return false;
+	return NextIndex != INDEX_NONE;
+}
+
+int32 ASpiderNavigation::FindNextNodeByFlowField(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex)
+{
+	FSpiderNavFlowFieldPtr FlowField = GetFlowField(NavGraph, EndIndex);
+	return FlowField->GetNextNode(StartIndex);
+}
+
+FSpiderNavFlowFieldPtr ASpiderNavigation::GetFlowField(const FSpiderNavGraph& NavGraph, int32 GoalIndex)
+{
+	const float MaxCost = FlowFieldMaxCost > 0.0f ? FlowFieldMaxCost : MAX_flt;
+	{
+		FScopeLock ScopeLock(&FlowFieldsLock);
+		for (int32 i = FlowFields.Num() - 1; i >= 0; i--) {
+			const TSharedPtr<FSpiderNavFlowField, ESPMode::ThreadSafe>& FlowField = FlowFields[i];
+			if (FlowField->GraphId == NavGraph.Id && FlowField->GoalIndex == GoalIndex && FlowField->MaxCost == MaxCost) {
+				TSharedPtr<FSpiderNavFlowField, ESPMode::ThreadSafe> Found = FlowField;
+				FlowFields.RemoveAt(i, 1, false);
+				FlowFields.Add(Found);
+				return Found;
+			}
+		}
 	}
 
-	NextLocation = NextNode->Location;
-	Normal = NextNode->Normal;
+	TSharedRef<FSpiderNavFlowField, ESPMode::ThreadSafe> NewFlowField = MakeShared<FSpiderNavFlowField, ESPMode::ThreadSafe>();
+	TUniquePtr<FSpiderNavSearchContext> Context = SearchContexts.Acquire();
+	NewFlowField->Build(NavGraph, *Context, GoalIndex, MaxCost);
+	SearchContexts.Release(MoveTemp(Context));
 
-	return true;
+	FScopeLock ScopeLock(&FlowFieldsLock);
+	FlowFields.Add(NewFlowField);
+	while (FlowFields.Num() > FMath::Max(FlowFieldsCacheSize, 1)) {
+		FlowFields.RemoveAt(0, 1, false);
+	}
+
+	return NewFlowField;
+}
+
+TArray<FSpiderNavPath> ASpiderNavigation::FindPaths(const TArray<FVector>& Starts, const TArray<FVector>& Ends)
+{
+	TArray<FSpiderNavPath> Paths;
+	if (Starts.Num() != Ends.Num()) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("FindPaths: number of starts and ends are different"));
+		return Paths;
+	}
+
+	if (!CheckGridReady(TEXT("FindPaths"))) {
+		return Paths;
+	}
+
+	const FSpiderNavGraph& NavGraph = *Graph;
+	TArray<int32> StartIndexes;
+	TArray<int32> EndIndexes;
+	FindClosestNodes(NavGraph, Starts, StartIndexes);
+	FindClosestNodes(NavGraph, Ends, EndIndexes);
+
+	TArray<TArray<int32>> NodesPaths;
+	TArray<bool> FoundCompletePaths;
+	FindNodesPaths(NavGraph, StartIndexes, EndIndexes, NodesPaths, FoundCompletePaths);
+
+	Paths.SetNum(Starts.Num());
+	for (int32 i = 0; i < Starts.Num(); i++) {
+		Paths[i].bFoundCompletePath = FoundCompletePaths[i] && IsLocationStreamedIn(NavGraph, Ends[i]);
+		Paths[i].Locations.Reserve(NodesPaths[i].Num());
+		for (int32 NodeIndex : NodesPaths[i]) {
+			Paths[i].Locations.Add(NavGraph.GetLocation(NodeIndex));
+		}
+	}
+
+	return Paths;
+}
+
+void ASpiderNavigation::FindNextLocationsAndNormals(const TArray<FVector>& CurrentLocations, const TArray<FVector>& TargetLocations, TArray<bool>& Found, TArray<FVector>& NextLocations, TArray<FVector>& Normals)
+{
+	Found.Reset();
+	NextLocations.Reset();
+	Normals.Reset();
+	if (CurrentLocations.Num() != TargetLocations.Num()) {
+		UE_LOG(SpiderNAV_LOG, Warning, TEXT("FindNextLocationsAndNormals: number of current and target locations are different"));
+		return;
+	}
+
+	if (!CheckGridReady(TEXT("FindNextLocationsAndNormals"))) {
+		return;
+	}
+
+	const FSpiderNavGraph& NavGraph = *Graph;
+	TArray<int32> StartIndexes;
+	TArray<int32> EndIndexes;
+	FindClosestNodes(NavGraph, CurrentLocations, StartIndexes);
+	FindClosestNodes(NavGraph, TargetLocations, EndIndexes);
+
+	Found.Init(false, CurrentLocations.Num());
+	NextLocations.Init(FVector::ZeroVector, CurrentLocations.Num());
+	Normals.Init(FVector::ZeroVector, CurrentLocations.Num());
+
+	// agents which are covered by flow fields do not need search
+	TArray<int32> NextIndexes;
+	NextIndexes.Init(INDEX_NONE, CurrentLocations.Num());
+	if (bUseFlowFields) {
+		for (int32 i = 0; i < CurrentLocations.Num(); i++) {
+			if (StartIndexes[i] != INDEX_NONE && EndIndexes[i] != INDEX_NONE && StartIndexes[i] != EndIndexes[i]) {
+				NextIndexes[i] = FindNextNodeByFlowField(NavGraph, StartIndexes[i], EndIndexes[i]);
+				if (NextIndexes[i] != INDEX_NONE) {
+					StartIndexes[i] = INDEX_NONE;
+				}
+			}
+		}
+	}
+
+	TArray<TArray<int32>> NodesPaths;
+	TArray<bool> FoundCompletePaths;
+	FindNodesPaths(NavGraph, StartIndexes, EndIndexes, NodesPaths, FoundCompletePaths);
+
+	for (int32 i = 0; i < CurrentLocations.Num(); i++) {
+		if (NodesPaths[i].Num() > 1) {
+			NextIndexes[i] = NodesPaths[i][1];
+		}
+		if (NextIndexes[i] != INDEX_NONE) {
+			Found[i] = true;
+			NextLocations[i] = NavGraph.GetLocation(NextIndexes[i]);
+			Normals[i] = NavGraph.GetNormal(NextIndexes[i]);
+		}
+	}
+}
+
+int32 ASpiderNavigation::FindNextLocationAndNormalAsync(FVector CurrentLocation, FVector TargetLocation, const FSpiderNavNextLocationQueryDelegate& OnNextLocationFound)
+{
+	if (!CheckGridReady(TEXT("FindNextLocationAndNormalAsync"))) {
+		return 0;
+	}
+
+	const int32 QueryId = StartQuery();
+	TWeakObjectPtr<ASpiderNavigation> WeakThis(this);
+	FSpiderNavGraphPtr QueryGraph = Graph;
+
+	PendingQueriesNum.Increment();
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [this, WeakThis, QueryGraph, QueryId, CurrentLocation, TargetLocation, OnNextLocationFound]() {
+		int32 NextIndex;
+		bool bFound = FindNextNode(*QueryGraph, CurrentLocation, TargetLocation, NextIndex);
+		FVector NextLocation = bFound ? QueryGraph->GetLocation(NextIndex) : FVector::ZeroVector;
+		FVector Normal = bFound ? QueryGraph->GetNormal(NextIndex) : FVector::ZeroVector;
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, QueryId, bFound, NextLocation, Normal, OnNextLocationFound]() {
+			ASpiderNavigation* Navigation = WeakThis.Get();
+			if (Navigation && Navigation->FinishQuery(QueryId)) {
+				OnNextLocationFound.ExecuteIfBound(QueryId, bFound, NextLocation, Normal);
+			}
+		});
+		PendingQueriesNum.Decrement();
+	});
+
+	return QueryId;
 }
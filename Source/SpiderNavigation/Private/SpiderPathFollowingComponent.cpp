@@ -0,0 +1,250 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderPathFollowingComponent.h"
+#include "SpiderNavigationModule.h"
+#include "EngineUtils.h"
+
+USpiderPathFollowingComponent::USpiderPathFollowingComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	Navigation = nullptr;
+	AcceptanceRadius = 50.0f;
+	CorridorRadius = 200.0f;
+	ReplansNum = 0;
+	TargetLocation = FVector::ZeroVector;
+	bHasTarget = false;
+	bFollowsActor = false;
+	NextPointIndex = 0;
+	bFoundCompletePath = false;
+	TargetNodeIndex = INDEX_NONE;
+	CheckedTargetLocation = FVector::ZeroVector;
+}
+
+void USpiderPathFollowingComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!Navigation) {
+		for (TActorIterator<ASpiderNavigation> It(GetWorld()); It; ++It) {
+			Navigation = *It;
+			break;
+		}
+	}
+
+	// tiles of streamed grid are kept around the owner
+	if (Navigation) {
+		Navigation->AddStreamingSource(GetOwner());
+	}
+}
+
+void USpiderPathFollowingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Navigation) {
+		Navigation->RemoveStreamingSource(GetOwner());
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void USpiderPathFollowingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	UpdatePath();
+}
+
+void USpiderPathFollowingComponent::SetTargetActor(AActor* InTargetActor)
+{
+	TargetActor = InTargetActor;
+	bHasTarget = InTargetActor != nullptr;
+	bFollowsActor = true;
+	PathGraph.Reset();
+}
+
+void USpiderPathFollowingComponent::SetTargetLocation(FVector InTargetLocation)
+{
+	TargetActor.Reset();
+	TargetLocation = InTargetLocation;
+	bHasTarget = true;
+	bFollowsActor = false;
+	PathGraph.Reset();
+}
+
+void USpiderPathFollowingComponent::ClearTarget()
+{
+	TargetActor.Reset();
+	bHasTarget = false;
+	PathGraph.Reset();
+	NodesPath.Reset();
+	NextPointIndex = 0;
+	TargetNodeIndex = INDEX_NONE;
+}
+
+bool USpiderPathFollowingComponent::GetNextLocationAndNormal(FVector& NextLocation, FVector& Normal) const
+{
+	if (!PathGraph.IsValid() || !NodesPath.Num()) {
+		return false;
+	}
+
+	const int32 NodeIndex = NodesPath[NextPointIndex];
+	NextLocation = PathGraph->GetLocation(NodeIndex);
+	Normal = PathGraph->GetNormal(NodeIndex);
+
+	return true;
+}
+
+bool USpiderPathFollowingComponent::HasReachedPathEnd() const
+{
+	if (!PathGraph.IsValid() || !NodesPath.Num() || NextPointIndex != NodesPath.Num() - 1 || !GetOwner()) {
+		return false;
+	}
+
+	const FVector EndLocation = PathGraph->GetLocation(NodesPath.Last());
+	return FVector::DistSquared(GetOwner()->GetActorLocation(), EndLocation) < FMath::Square(AcceptanceRadius);
+}
+
+TArray<FVector> USpiderPathFollowingComponent::GetRemainingPath() const
+{
+	TArray<FVector> Path;
+	if (!PathGraph.IsValid()) {
+		return Path;
+	}
+
+	Path.Reserve(NodesPath.Num() - NextPointIndex);
+	for (int32 i = NextPointIndex; i < NodesPath.Num(); i++) {
+		Path.Add(PathGraph->GetLocation(NodesPath[i]));
+	}
+
+	return Path;
+}
+
+void USpiderPathFollowingComponent::UpdatePath()
+{
+	AActor* Owner = GetOwner();
+	FVector CurrentTargetLocation;
+	if (!Navigation || !Owner || !GetTargetLocation(CurrentTargetLocation)) {
+		return;
+	}
+
+	// path is planned when loading of the grid is finished
+	const FSpiderNavGraphPtr& CurrentGraph = Navigation->Graph;
+	if (!Navigation->IsGridReady() || !CurrentGraph.IsValid() || CurrentGraph->Num() == 0) {
+		return;
+	}
+
+	const FVector OwnerLocation = Owner->GetActorLocation();
+
+	bool bNeedsReplan = PathGraph != CurrentGraph && !AdoptGraph(CurrentGraph, CurrentTargetLocation);
+
+	// closest node of target is looked up only when target moves
+	if (!bNeedsReplan && CurrentTargetLocation != CheckedTargetLocation) {
+		CheckedTargetLocation = CurrentTargetLocation;
+		bNeedsReplan = Navigation->FindClosestNode(*PathGraph, CurrentTargetLocation, TargetHandle) != TargetNodeIndex;
+	}
+
+	if (bNeedsReplan) {
+		Replan(OwnerLocation, CurrentTargetLocation);
+		return;
+	}
+
+	// tile of target is requested while it is followed, so partial path is completed when the tile is streamed in
+	Navigation->IsLocationStreamedIn(*PathGraph, CurrentTargetLocation);
+
+	if (!NodesPath.Num()) {
+		return;
+	}
+
+	const FSpiderNavGraph& NavGraph = *PathGraph;
+	const float AcceptanceRadiusSquared = FMath::Square(AcceptanceRadius);
+	while (NextPointIndex < NodesPath.Num() - 1 && FVector::DistSquared(OwnerLocation, NavGraph.GetLocation(NodesPath[NextPointIndex])) < AcceptanceRadiusSquared) {
+		NextPointIndex++;
+	}
+
+	const FVector NextLocation = NavGraph.GetLocation(NodesPath[NextPointIndex]);
+	const float DriftSquared = NextPointIndex > 0
+		? FMath::PointDistToSegmentSquared(OwnerLocation, NavGraph.GetLocation(NodesPath[NextPointIndex - 1]), NextLocation)
+		: FVector::DistSquared(OwnerLocation, NextLocation);
+	if (DriftSquared > FMath::Square(CorridorRadius)) {
+		Replan(OwnerLocation, CurrentTargetLocation);
+	}
+}
+
+bool USpiderPathFollowingComponent::Replan(const FVector& OwnerLocation, const FVector& InTargetLocation)
+{
+	PathGraph = Navigation->Graph;
+	CheckedTargetLocation = InTargetLocation;
+	ReplansNum++;
+
+	const int32 StartIndex = Navigation->FindClosestNode(*PathGraph, OwnerLocation, OwnerHandle);
+	TargetNodeIndex = Navigation->FindClosestNode(*PathGraph, InTargetLocation, TargetHandle);
+
+	bFoundCompletePath = false;
+	Navigation->FindNodesPath(*PathGraph, StartIndex, TargetNodeIndex, NodesPath, bFoundCompletePath);
+
+	// the first node is where owner already is
+	NextPointIndex = NodesPath.Num() > 1 ? 1 : 0;
+
+	return NodesPath.Num() > 0;
+}
+
+bool USpiderPathFollowingComponent::AdoptGraph(const FSpiderNavGraphPtr& NewGraph, const FVector& InTargetLocation)
+{
+	// partial path could be completed by new tiles
+	if (!PathGraph.IsValid() || NewGraph->PreviousId != PathGraph->Id || !bFoundCompletePath) {
+		return false;
+	}
+
+	for (int32 i = FMath::Max(NextPointIndex - 1, 0); i < NodesPath.Num(); i++) {
+		if (!NewGraph->IsNodeKept(NodesPath[i])) {
+			return false;
+		}
+	}
+
+	// tiles streamed in around target can have closer node
+	CheckedTargetLocation = InTargetLocation;
+	if (Navigation->FindClosestNode(*NewGraph, InTargetLocation, TargetHandle) != TargetNodeIndex) {
+		return false;
+	}
+
+	PathGraph = NewGraph;
+	return true;
+}
+
+bool USpiderPathFollowingComponent::GetTargetLocation(FVector& OutLocation) const
+{
+	if (!bHasTarget) {
+		return false;
+	}
+
+	if (bFollowsActor) {
+		// target actor could be destroyed
+		if (!TargetActor.IsValid()) {
+			return false;
+		}
+		OutLocation = TargetActor->GetActorLocation();
+		return true;
+	}
+
+	OutLocation = TargetLocation;
+	return true;
+}
@@ -0,0 +1,247 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavigation.h"
+#include "SpiderNavigationModule.h"
+#include "SpiderNavGridAsset.h"
+#include "SpiderNavGraph.h"
+#include "Misc/AutomationTest.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Forwards everything to the wrapped allocator and counts allocations made by one thread */
+class FSpiderNavCountingMalloc : public FMalloc
+{
+public:
+	FSpiderNavCountingMalloc()
+	{
+		InnerMalloc = nullptr;
+		CountedThreadId = 0;
+	}
+
+	/** Puts itself instead of GMalloc and starts counting allocations of the calling thread */
+	void Begin()
+	{
+		AllocationsNum.Reset();
+		CountedThreadId = FPlatformTLS::GetCurrentThreadId();
+		InnerMalloc = GMalloc;
+		GMalloc = this;
+	}
+
+	/** Restores GMalloc and returns number of allocations since Begin */
+	int32 End()
+	{
+		GMalloc = InnerMalloc;
+		CountedThreadId = 0;
+		return AllocationsNum.GetValue();
+	}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		// reallocation to zero bytes frees memory
+		if (Count > 0) {
+			CountAllocation();
+		}
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return InnerMalloc->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("SpiderNavCountingMalloc");
+	}
+
+protected:
+	void CountAllocation()
+	{
+		if (FPlatformTLS::GetCurrentThreadId() == CountedThreadId) {
+			AllocationsNum.Increment();
+		}
+	}
+
+	FMalloc* InnerMalloc;
+
+	uint32 CountedThreadId;
+
+	FThreadSafeCounter AllocationsNum;
+};
+
+/** Other threads can still be inside of it after GMalloc is restored, so it is never destroyed while the program runs */
+static FSpiderNavCountingMalloc CountingMalloc;
+
+/** Square floor of nodes with a wall in the middle, which paths have to go around. Clusters and contraction hierarchy are computed for it */
+static void MakeTestGridData(FSpiderNavGridData& OutGridData)
+{
+	const int32 Size = 32;
+	const float Step = 100.0f;
+	const int32 WallX = Size / 2;
+	const int32 WallGapY = 4;
+
+	auto IsFree = [&](int32 X, int32 Y) {
+		return X >= 0 && Y >= 0 && X < Size && Y < Size && (X != WallX || Y < WallGapY);
+	};
+
+	TMap<FIntPoint, int32> Indexes;
+	OutGridData.GridStepSize = Step;
+	for (int32 Y = 0; Y < Size; Y++) {
+		for (int32 X = 0; X < Size; X++) {
+			if (IsFree(X, Y)) {
+				Indexes.Add(FIntPoint(X, Y), OutGridData.Locations.Add(FVector(X * Step, Y * Step, 0.0f)));
+				OutGridData.Normals.Add(FVector(0.0f, 0.0f, 1.0f));
+			}
+		}
+	}
+
+	const FIntPoint Directions[] = { FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1) };
+	OutGridData.EdgeOffsets.Add(0);
+	for (const FVector& Location : OutGridData.Locations) {
+		const FIntPoint Point(FMath::RoundToInt(Location.X / Step), FMath::RoundToInt(Location.Y / Step));
+		for (const FIntPoint& Direction : Directions) {
+			if (const int32* Neighbor = Indexes.Find(Point + Direction)) {
+				OutGridData.EdgeTargets.Add(*Neighbor);
+			}
+		}
+		OutGridData.EdgeOffsets.Add(OutGridData.EdgeTargets.Num());
+	}
+
+	FSpiderNavGridData GraphData = OutGridData;
+	FSpiderNavGraph NavGraph;
+	NavGraph.BuildFromRows(MoveTemp(GraphData.Locations), MoveTemp(GraphData.Normals), MoveTemp(GraphData.EdgeOffsets), MoveTemp(GraphData.EdgeTargets), Step);
+	FSpiderNavClusters::Compute(NavGraph, Step * 8.0f, OutGridData.ClusterIds, OutGridData.AbstractEdges);
+	FSpiderNavContractionHierarchy::Compute(NavGraph, OutGridData.Ranks, OutGridData.HierarchyEdges);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpiderNavZeroAllocationsTest, "SpiderNavigation.FindPathInto.ZeroAllocations", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FSpiderNavZeroAllocationsTest::RunTest(const FString& Parameters)
+{
+	USpiderNavGridAsset* GridAsset = NewObject<USpiderNavGridAsset>();
+	GridAsset->AddToRoot();
+	MakeTestGridData(GridAsset->GridData);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	ASpiderNavigation* Navigation = World->SpawnActor<ASpiderNavigation>();
+	Navigation->GridAsset = GridAsset;
+	Navigation->HeuristicMode = ESpiderNavHeuristic::Landmarks;
+	// cache would hide the search, so it is checked separately
+	Navigation->PathCacheSize = 0;
+	TestTrue(TEXT("Grid is loaded"), Navigation->LoadGrid());
+
+	// queries go around the wall, so they expand many nodes of both its sides
+	const TPair<FVector, FVector> Queries[] = {
+		TPair<FVector, FVector>(FVector(100.0f, 3000.0f, 0.0f), FVector(3000.0f, 3000.0f, 0.0f)),
+		TPair<FVector, FVector>(FVector(0.0f, 0.0f, 0.0f), FVector(3100.0f, 3100.0f, 0.0f)),
+		TPair<FVector, FVector>(FVector(1400.0f, 2000.0f, 0.0f), FVector(1800.0f, 2000.0f, 0.0f)),
+		TPair<FVector, FVector>(FVector(500.0f, 500.0f, 0.0f), FVector(600.0f, 500.0f, 0.0f))
+	};
+
+	struct FMode
+	{
+		const TCHAR* Name;
+		ESpiderNavSearchMode SearchMode;
+		ESpiderNavHeuristic HeuristicMode;
+	};
+	const FMode Modes[] = {
+		{ TEXT("A-star"), ESpiderNavSearchMode::AStar, ESpiderNavHeuristic::Euclidean },
+		{ TEXT("A-star with landmarks"), ESpiderNavSearchMode::AStar, ESpiderNavHeuristic::Landmarks },
+		{ TEXT("hierarchical"), ESpiderNavSearchMode::Hierarchical, ESpiderNavHeuristic::Euclidean },
+		{ TEXT("contraction hierarchy"), ESpiderNavSearchMode::ContractionHierarchy, ESpiderNavHeuristic::Euclidean },
+		{ TEXT("bidirectional"), ESpiderNavSearchMode::Bidirectional, ESpiderNavHeuristic::Landmarks }
+	};
+
+	TArray<FVector> Path;
+	bool bFoundCompletePath = false;
+	for (const FMode& Mode : Modes) {
+		Navigation->SearchMode = Mode.SearchMode;
+		Navigation->HeuristicMode = Mode.HeuristicMode;
+
+		// the first pass grows buffers to the longest path, the second one runs on them
+		for (const TPair<FVector, FVector>& Query : Queries) {
+			TestTrue(FString::Printf(TEXT("Path is found by %s search"), Mode.Name), Navigation->FindPathInto(Query.Key, Query.Value, Path, bFoundCompletePath) && bFoundCompletePath);
+		}
+
+		CountingMalloc.Begin();
+		for (const TPair<FVector, FVector>& Query : Queries) {
+			Navigation->FindPathInto(Query.Key, Query.Value, Path, bFoundCompletePath);
+		}
+		const int32 AllocationsNum = CountingMalloc.End();
+		TestEqual(FString::Printf(TEXT("Allocations of repeated queries of %s search"), Mode.Name), AllocationsNum, 0);
+	}
+
+	// cache which is full reuses memory of evicted paths for new ones
+	Navigation->SearchMode = ESpiderNavSearchMode::AStar;
+	Navigation->PathCacheSize = 2;
+	Navigation->LoadGrid();
+	for (int32 Pass = 0; Pass < 2; Pass++) {
+		for (const TPair<FVector, FVector>& Query : Queries) {
+			Navigation->FindPathInto(Query.Key, Query.Value, Path, bFoundCompletePath);
+		}
+	}
+
+	CountingMalloc.Begin();
+	for (const TPair<FVector, FVector>& Query : Queries) {
+		Navigation->FindPathInto(Query.Key, Query.Value, Path, bFoundCompletePath);
+	}
+	const int32 CachedAllocationsNum = CountingMalloc.End();
+	TestEqual(TEXT("Allocations of repeated queries with path cache"), CachedAllocationsNum, 0);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	GridAsset->RemoveFromRoot();
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
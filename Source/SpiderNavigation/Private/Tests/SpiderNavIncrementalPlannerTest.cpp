@@ -0,0 +1,145 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+
+#include "SpiderNavigationModule.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavIncrementalPlanner.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Floor with diagonal edges and random pillars which paths go around */
+static void MakeChaseGraph(FSpiderNavGraph& OutGraph, int32 Size)
+{
+	const float Step = 100.0f;
+	FRandomStream RandomStream(Size);
+
+	TArray<int32> Indexes;
+	Indexes.Init(INDEX_NONE, Size * Size);
+	TArray<FVector> Locations;
+	TArray<FVector> Normals;
+	for (int32 Y = 0; Y < Size; Y++) {
+		for (int32 X = 0; X < Size; X++) {
+			if (RandomStream.FRand() >= 0.2f) {
+				Indexes[Y * Size + X] = Locations.Add(FVector(X * Step, Y * Step, 0.0f));
+				Normals.Add(FVector(0.0f, 0.0f, 1.0f));
+			}
+		}
+	}
+
+	TArray<int32> EdgeOffsets;
+	TArray<int32> EdgeTargets;
+	EdgeOffsets.Add(0);
+	for (int32 Y = 0; Y < Size; Y++) {
+		for (int32 X = 0; X < Size; X++) {
+			if (Indexes[Y * Size + X] == INDEX_NONE) {
+				continue;
+			}
+			for (int32 DY = -1; DY <= 1; DY++) {
+				for (int32 DX = -1; DX <= 1; DX++) {
+					const int32 NX = X + DX;
+					const int32 NY = Y + DY;
+					if ((DX || DY) && NX >= 0 && NY >= 0 && NX < Size && NY < Size && Indexes[NY * Size + NX] != INDEX_NONE) {
+						EdgeTargets.Add(Indexes[NY * Size + NX]);
+					}
+				}
+			}
+			EdgeOffsets.Add(EdgeTargets.Num());
+		}
+	}
+
+	OutGraph.BuildFromRows(MoveTemp(Locations), MoveTemp(Normals), MoveTemp(EdgeOffsets), MoveTemp(EdgeTargets), Step);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpiderNavMovingTargetTest, "SpiderNavigation.IncrementalPlanner.MovingTarget", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FSpiderNavMovingTargetTest::RunTest(const FString& Parameters)
+{
+	FSpiderNavGraph NavGraph;
+	MakeChaseGraph(NavGraph, 128);
+
+	// the agent and the target start in opposite corners of the same component
+	FRandomStream RandomStream(NavGraph.Num());
+	const int32 StartIndex = 0;
+	int32 TargetIndex = NavGraph.Num() - 1;
+	while (!NavGraph.IsReachable(StartIndex, TargetIndex)) {
+		TargetIndex--;
+	}
+
+	// the target moves to a random neighbor every other tick and the agent follows the planner every tick, so it catches the target
+	FSpiderNavIncrementalPlanner Planner;
+	FSpiderNavIncrementalPlanner RestartedPlanner;
+	int32 AgentIndex = StartIndex;
+	int32 TicksNum = 0;
+	int64 ExpandedNodesNum = 0;
+	int64 RestartedExpandedNodesNum = 0;
+	int32 MaxExpandedNodesNum = 0;
+	for (int32 Tick = 0; Tick < 4 * NavGraph.Num() && AgentIndex != TargetIndex; Tick++) {
+		if (Tick % 2) {
+			const int32 EdgesBegin = NavGraph.GetEdgesBegin(TargetIndex);
+			TargetIndex = NavGraph.EdgeTargets[EdgesBegin + RandomStream.RandHelper(NavGraph.GetEdgesEnd(TargetIndex) - EdgesBegin)];
+			if (TargetIndex == AgentIndex) {
+				break;
+			}
+		}
+
+		const int32 NextIndex = Planner.FindNextNode(NavGraph, AgentIndex, TargetIndex);
+
+		// the same query searched from scratch
+		RestartedPlanner.Reset();
+		const int32 RestartedNextIndex = RestartedPlanner.FindNextNode(NavGraph, AgentIndex, TargetIndex);
+
+		if (NextIndex == INDEX_NONE || RestartedNextIndex == INDEX_NONE) {
+			AddError(FString::Printf(TEXT("Tick %d: next node from %d to %d is not found"), Tick, AgentIndex, TargetIndex));
+			return false;
+		}
+
+		// the first search is the same for both planners, only moves of the target and the agent are compared
+		if (Tick > 0) {
+			TicksNum++;
+			ExpandedNodesNum += Planner.ExpandedNodesNum;
+			RestartedExpandedNodesNum += RestartedPlanner.ExpandedNodesNum;
+			MaxExpandedNodesNum = FMath::Max(MaxExpandedNodesNum, Planner.ExpandedNodesNum);
+		}
+
+		AgentIndex = NextIndex;
+	}
+
+	TestTrue(TEXT("The agent catches the target"), AgentIndex == TargetIndex);
+	if (!TicksNum) {
+		AddError(TEXT("The agent has caught the target at once"));
+		return false;
+	}
+
+	const double ExpandedPerTick = (double)ExpandedNodesNum / TicksNum;
+	const double RestartedExpandedPerTick = (double)RestartedExpandedNodesNum / TicksNum;
+	AddInfo(FString::Printf(TEXT("ticks = %d, expanded per tick = %f, max expanded per tick = %d, expanded per tick when restarted = %f"),
+		TicksNum, ExpandedPerTick, MaxExpandedNodesNum, RestartedExpandedPerTick));
+
+	// moves by one node mostly keep the goal closed or on the fringe of the tree
+	TestTrue(TEXT("One-node moves of the target expand only a few nodes"), ExpandedPerTick * 10.0 < RestartedExpandedPerTick);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,236 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#include "SpiderNavigationModule.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavSearchContext.h"
+#include "Misc/AutomationTest.h"
+#include <algorithm>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Open list of search context: indexed 4-ary heap with decrease-key */
+struct FSpiderNavIndexedOpenList
+{
+	FSpiderNavSearchContext& Context;
+
+	FSpiderNavIndexedOpenList(FSpiderNavSearchContext& InContext) : Context(InContext) {}
+
+	void Reset() {}
+
+	bool IsEmpty() const { return !Context.HasOpenNodes(); }
+
+	void Push(int32 Index) { Context.PushOpenNode(Index); }
+
+	void Decrease(int32 Index) { Context.DecreaseOpenNode(Index); }
+
+	int32 Pop() { return Context.PopOpenNode(); }
+};
+
+/** Open list which A-star used before the indexed heap: heap of std algorithms which is made again as a whole when F-value of opened node decreases */
+struct FSpiderNavLegacyOpenList
+{
+	FSpiderNavSearchContext& Context;
+
+	TArray<int32> Heap;
+
+	FSpiderNavLegacyOpenList(FSpiderNavSearchContext& InContext) : Context(InContext) {}
+
+	bool operator()(int32 A, int32 B) const
+	{
+		return Context.FindNode(A)->F > Context.FindNode(B)->F;
+	}
+
+	void Reset() { Heap.Reset(); }
+
+	bool IsEmpty() const { return Heap.Num() == 0; }
+
+	void Push(int32 Index)
+	{
+		Heap.Add(Index);
+		std::push_heap(Heap.GetData(), Heap.GetData() + Heap.Num(), *this);
+	}
+
+	void Decrease(int32 Index)
+	{
+		std::make_heap(Heap.GetData(), Heap.GetData() + Heap.Num(), *this);
+	}
+
+	int32 Pop()
+	{
+		std::pop_heap(Heap.GetData(), Heap.GetData() + Heap.Num(), *this);
+		return Heap.Pop(false);
+	}
+};
+
+/** Floor with diagonal edges and random pillars. Diagonals give many nodes which are reached with lower cost after they have been opened */
+static void MakeBenchmarkGraph(FSpiderNavGraph& OutGraph)
+{
+	const int32 Size = 256;
+	const float Step = 100.0f;
+	FRandomStream RandomStream(Size);
+
+	TArray<int32> Indexes;
+	Indexes.Init(INDEX_NONE, Size * Size);
+	TArray<FVector> Locations;
+	TArray<FVector> Normals;
+	for (int32 Y = 0; Y < Size; Y++) {
+		for (int32 X = 0; X < Size; X++) {
+			if (RandomStream.FRand() >= 0.2f) {
+				Indexes[Y * Size + X] = Locations.Add(FVector(X * Step, Y * Step, 0.0f));
+				Normals.Add(FVector(0.0f, 0.0f, 1.0f));
+			}
+		}
+	}
+
+	TArray<int32> EdgeOffsets;
+	TArray<int32> EdgeTargets;
+	EdgeOffsets.Add(0);
+	for (int32 Y = 0; Y < Size; Y++) {
+		for (int32 X = 0; X < Size; X++) {
+			if (Indexes[Y * Size + X] == INDEX_NONE) {
+				continue;
+			}
+			for (int32 DY = -1; DY <= 1; DY++) {
+				for (int32 DX = -1; DX <= 1; DX++) {
+					const int32 NX = X + DX;
+					const int32 NY = Y + DY;
+					if ((DX || DY) && NX >= 0 && NY >= 0 && NX < Size && NY < Size && Indexes[NY * Size + NX] != INDEX_NONE) {
+						EdgeTargets.Add(Indexes[NY * Size + NX]);
+					}
+				}
+			}
+			EdgeOffsets.Add(EdgeTargets.Num());
+		}
+	}
+
+	OutGraph.BuildFromRows(MoveTemp(Locations), MoveTemp(Normals), MoveTemp(EdgeOffsets), MoveTemp(EdgeTargets), Step);
+}
+
+/** The same A-star as ASpiderNavigation::StepNodesPath with Euclidean heuristic. Returns cost of path or -1 if end is not reached */
+template <typename TOpenList>
+static float SearchPathCost(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, TOpenList& OpenList, int32 StartIndex, int32 EndIndex, int64& ExpandedNodesNum, int64& DecreasedNodesNum)
+{
+	Context.Reset(NavGraph.Num());
+	OpenList.Reset();
+	const FVector EndLocation = NavGraph.GetLocation(EndIndex);
+
+	Context.GetNode(StartIndex).bOpened = true;
+	OpenList.Push(StartIndex);
+
+	while (!OpenList.IsEmpty()) {
+		const int32 NodeIndex = OpenList.Pop();
+		FSpiderNavSearchNode& SearchNode = Context.GetNode(NodeIndex);
+		SearchNode.bClosed = true;
+		ExpandedNodesNum++;
+
+		if (NodeIndex == EndIndex) {
+			return SearchNode.G;
+		}
+
+		const int32 EdgesEnd = NavGraph.GetEdgesEnd(NodeIndex);
+		for (int32 Edge = NavGraph.GetEdgesBegin(NodeIndex); Edge != EdgesEnd; ++Edge) {
+			const int32 NeighborIndex = NavGraph.EdgeTargets[Edge];
+			FSpiderNavSearchNode& SearchNeighbor = Context.GetNode(NeighborIndex);
+			if (SearchNeighbor.bClosed) {
+				continue;
+			}
+
+			const float NewG = SearchNode.G + NavGraph.EdgeCosts[Edge];
+			if (!SearchNeighbor.bOpened || NewG < SearchNeighbor.G) {
+				SearchNeighbor.G = NewG;
+				SearchNeighbor.F = NewG + (NavGraph.GetLocation(NeighborIndex) - EndLocation).Size();
+				SearchNeighbor.ParentIndex = NodeIndex;
+
+				if (!SearchNeighbor.bOpened) {
+					SearchNeighbor.bOpened = true;
+					OpenList.Push(NeighborIndex);
+				} else {
+					DecreasedNodesNum++;
+					OpenList.Decrease(NeighborIndex);
+				}
+			}
+		}
+	}
+
+	return -1.0f;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpiderNavOpenListBenchmark, "SpiderNavigation.AStar.OpenListBenchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FSpiderNavOpenListBenchmark::RunTest(const FString& Parameters)
+{
+	FSpiderNavGraph NavGraph;
+	MakeBenchmarkGraph(NavGraph);
+
+	// both open lists get the same queries between nodes of the same component
+	const int32 QueriesNum = 200;
+	FRandomStream RandomStream(NavGraph.Num());
+	TArray<TPair<int32, int32>> Queries;
+	while (Queries.Num() < QueriesNum) {
+		const int32 StartIndex = RandomStream.RandHelper(NavGraph.Num());
+		const int32 EndIndex = RandomStream.RandHelper(NavGraph.Num());
+		if (NavGraph.IsReachable(StartIndex, EndIndex)) {
+			Queries.Emplace(StartIndex, EndIndex);
+		}
+	}
+
+	FSpiderNavSearchContext Context;
+	TArray<float> Costs;
+
+	auto RunQueries = [&](const TCHAR* Name, auto& OpenList) {
+		int64 ExpandedNodesNum = 0;
+		int64 DecreasedNodesNum = 0;
+		Costs.Reset();
+		const double StartTime = FPlatformTime::Seconds();
+		for (const TPair<int32, int32>& Query : Queries) {
+			Costs.Add(SearchPathCost(NavGraph, Context, OpenList, Query.Key, Query.Value, ExpandedNodesNum, DecreasedNodesNum));
+		}
+		const double Seconds = FMath::Max(FPlatformTime::Seconds() - StartTime, SMALL_NUMBER);
+
+		const double ExpandedPerSecond = ExpandedNodesNum / Seconds;
+		AddInfo(FString::Printf(TEXT("%s: nodes = %d, queries = %d, time = %f ms, expanded per query = %f, decreased per query = %f, expanded per second = %f"),
+			Name, NavGraph.Num(), QueriesNum, Seconds * 1000.0, (double)ExpandedNodesNum / QueriesNum, (double)DecreasedNodesNum / QueriesNum, ExpandedPerSecond));
+		return ExpandedPerSecond;
+	};
+
+	FSpiderNavLegacyOpenList LegacyOpenList(Context);
+	const double LegacyExpandedPerSecond = RunQueries(TEXT("make_heap open list"), LegacyOpenList);
+	const TArray<float> LegacyCosts = Costs;
+
+	FSpiderNavIndexedOpenList IndexedOpenList(Context);
+	const double IndexedExpandedPerSecond = RunQueries(TEXT("indexed 4-ary heap"), IndexedOpenList);
+
+	// ties of F-values can be broken in another order, but the cost of found path is the same
+	for (int32 i = 0; i < QueriesNum; i++) {
+		if (!FMath::IsNearlyEqual(Costs[i], LegacyCosts[i], 0.01f)) {
+			AddError(FString::Printf(TEXT("Query %d: cost with indexed heap %f differs from cost with make_heap %f"), i, Costs[i], LegacyCosts[i]));
+			break;
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("Indexed heap expands %f times more nodes per second"), IndexedExpandedPerSecond / LegacyExpandedPerSecond));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,86 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderNavGridSaveGame.h"
+
+struct FSpiderNavGraph;
+
+/**
+ * Spatial clusters of grid and abstract graph between their entrances for hierarchical search.
+ * Search on abstract graph finds clusters which path goes through, then usual search is limited by these clusters
+ */
+struct FSpiderNavClusters
+{
+public:
+	FSpiderNavClusters();
+
+	/**
+	 * Splits nodes of grid into cubic clusters with edge ClusterSize, chooses entrances on borders between clusters
+	 * and finds costs of paths between entrances inside each cluster. Done offline when grid is saved
+	 */
+	static void Compute(const FSpiderNavGraph& NavGraph, float ClusterSize, TArray<int32>& OutClusterIds, TArray<FSpiderNavAbstractEdge>& OutAbstractEdges);
+
+	/** Builds abstract graph from precomputed data. Clusters and edges use indexes of nodes of grid */
+	void Build(TArray<int32>&& InClusterIds, const TArray<FSpiderNavAbstractEdge>& InAbstractEdges);
+
+	void Empty();
+
+	/** Whether grid has been clustered */
+	FORCEINLINE bool IsEmpty() const
+	{
+		return ClusterIds.Num() == 0;
+	}
+
+	/** Returns memory used by clusters in bytes */
+	FORCEINLINE int32 GetAllocatedSize() const
+	{
+		return ClusterIds.GetAllocatedSize() + AbstractNodes.GetAllocatedSize() + EntrancesOffsets.GetAllocatedSize() + Entrances.GetAllocatedSize()
+			+ EdgeOffsets.GetAllocatedSize() + EdgeTargets.GetAllocatedSize() + EdgeCosts.GetAllocatedSize();
+	}
+
+	/** Cluster of each node of grid */
+	TArray<int32> ClusterIds;
+
+	/** Number of clusters */
+	int32 ClustersNum;
+
+	/** Node of grid for each node of abstract graph */
+	TArray<int32> AbstractNodes;
+
+	/** Entrances of cluster i are in range [EntrancesOffsets[i], EntrancesOffsets[i + 1]) of Entrances */
+	TArray<int32> EntrancesOffsets;
+
+	/** Indexes of abstract nodes grouped by clusters */
+	TArray<int32> Entrances;
+
+	/** Edges of abstract node i are in range [EdgeOffsets[i], EdgeOffsets[i + 1]) of EdgeTargets and EdgeCosts */
+	TArray<int32> EdgeOffsets;
+
+	/** Indexes of abstract nodes at the end of edges */
+	TArray<int32> EdgeTargets;
+
+	/** Lengths of the shortest paths between abstract nodes */
+	TArray<float> EdgeCosts;
+};
@@ -0,0 +1,85 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderNavGridSaveGame.h"
+
+struct FSpiderNavGraph;
+struct FSpiderNavSearchContext;
+
+/**
+ * Contraction hierarchy of grid. Nodes are contracted one by one, shortcuts keep distances between the remaining ones.
+ * Query searches only edges going to nodes of higher rank from both ends, which visits a tiny part of grid
+ */
+struct FSpiderNavContractionHierarchy
+{
+public:
+	FSpiderNavContractionHierarchy();
+
+	/**
+	 * Orders nodes by importance and contracts them, adding shortcuts where no witness path exists.
+	 * Edges of grid are expected to be symmetric, so only upward edges are written. Done offline when grid is saved
+	 */
+	static void Compute(const FSpiderNavGraph& NavGraph, TArray<int32>& OutRanks, TArray<FSpiderNavHierarchyEdge>& OutUpwardEdges);
+
+	/** Builds hierarchy from precomputed data. Edges use indexes of nodes of grid */
+	void Build(TArray<int32>&& InRanks, const TArray<FSpiderNavHierarchyEdge>& InUpwardEdges);
+
+	void Empty();
+
+	/** Whether hierarchy has been built */
+	FORCEINLINE bool IsEmpty() const
+	{
+		return Ranks.Num() == 0;
+	}
+
+	/** Returns memory used by hierarchy in bytes */
+	FORCEINLINE int32 GetAllocatedSize() const
+	{
+		return Ranks.GetAllocatedSize() + EdgeOffsets.GetAllocatedSize() + EdgeTargets.GetAllocatedSize() + EdgeCosts.GetAllocatedSize() + EdgeMiddles.GetAllocatedSize();
+	}
+
+	/** Bidirectional search over upward edges. Writes nodes of grid from start to end to OutPath. Returns false if end is not reachable.
+	 * Buffers of ForwardContext are used for unpacking, so the search does not allocate once they have grown */
+	bool FindPath(FSpiderNavSearchContext& ForwardContext, FSpiderNavSearchContext& BackwardContext, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath) const;
+
+	/** Order of contraction of each node of grid */
+	TArray<int32> Ranks;
+
+	/** Upward edges of node i are in range [EdgeOffsets[i], EdgeOffsets[i + 1]) of EdgeTargets, EdgeCosts and EdgeMiddles */
+	TArray<int32> EdgeOffsets;
+
+	/** Nodes of higher rank at the end of edges */
+	TArray<int32> EdgeTargets;
+
+	/** Costs of edges */
+	TArray<float> EdgeCosts;
+
+	/** Nodes which shortcuts go through or INDEX_NONE for edges of grid */
+	TArray<int32> EdgeMiddles;
+
+protected:
+	/** Appends nodes of grid which edge between From and To stands for. From itself is not appended. Stack is scratch memory */
+	void UnpackEdge(int32 From, int32 To, TArray<int32>& OutPath, TArray<TPair<int32, int32>>& Stack) const;
+};
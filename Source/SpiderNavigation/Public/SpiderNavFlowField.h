@@ -0,0 +1,68 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavSearchContext.h"
+
+/** Next hop towards one goal node for every node of grid within cost radius. Built by one search from the goal */
+struct FSpiderNavFlowField
+{
+public:
+	FSpiderNavFlowField();
+
+	/**
+	 * Runs Dijkstra from goal node over reversed edges. Edges written by SpiderNavGridBuilder are symmetric, so reversed edges are the same.
+	 * Nodes farther than MaxCost from the goal are not reached. Zero MaxCost means no limit
+	 */
+	void Build(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 InGoalIndex, float InMaxCost);
+
+	/**
+	 * Moves the field to grid NewGraphId stitched from grid which it has been built for. Returns false if any reached node is not kept there.
+	 * Kept nodes have the same edges, so paths of the field stay valid though they may miss shortcuts through new tiles
+	 */
+	bool Rebase(uint32 OldGraphId, uint32 NewGraphId, TFunctionRef<bool(int32)> IsNodeKept);
+
+	/** Returns next node on the shortest path from node to the goal or INDEX_NONE if node has not been reached */
+	FORCEINLINE int32 GetNextNode(int32 Index) const
+	{
+		// nodes of grid stitched after the field has been built can be out of its range
+		return Index < NextNodes.Num() ? NextNodes[Index] : INDEX_NONE;
+	}
+
+	/** Id of grid which the field is built for */
+	uint32 GraphId;
+
+	/** Index of goal node */
+	int32 GoalIndex;
+
+	/** Cost radius used to build the field */
+	float MaxCost;
+
+protected:
+	/** Next node towards the goal for each node of grid */
+	TArray<int32> NextNodes;
+};
+
+typedef TSharedPtr<const FSpiderNavFlowField, ESPMode::ThreadSafe> FSpiderNavFlowFieldPtr;
@@ -0,0 +1,227 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderNavSpatialIndex.h"
+#include "SpiderNavClusters.h"
+#include "SpiderNavLandmarks.h"
+#include "SpiderNavContractionHierarchy.h"
+
+struct FSpiderNavTiles;
+
+/** Location of node of quantized grid as 16-bit offsets from corner of its tile */
+struct FSpiderNavQuantizedLocation
+{
+	uint16 X;
+
+	uint16 Y;
+
+	uint16 Z;
+
+	/** Index of tile in TileOrigins */
+	uint16 Tile;
+};
+
+/** Runtime navigation grid. Properties of nodes are stored in separate arrays, edges are stored as compressed sparse rows */
+struct FSpiderNavGraph
+{
+public:
+	FSpiderNavGraph();
+
+	/** Builds graph from locations and normals of nodes and from edges given as pairs (EdgeSources[i], EdgeTargets[i]) */
+	void Build(TArray<FVector>&& InLocations, TArray<FVector>&& InNormals, const TArray<int32>& InEdgeSources, const TArray<int32>& InEdgeTargets, float GridStepSize);
+
+	/** Builds graph from locations and normals of nodes and from edges already grouped into compressed sparse rows */
+	void BuildFromRows(TArray<FVector>&& InLocations, TArray<FVector>&& InNormals, TArray<int32>&& InEdgeOffsets, TArray<int32>&& InEdgeTargets, float GridStepSize);
+
+	/**
+	 * Stitches grid from streamed tiles. Tiles which are also in Previous grid built from the same tiles keep their ranges of nodes, and
+	 * ranges of tiles which have been streamed out are reused by new ones, so only nodes of new tiles and edges of their neighbors are computed,
+	 * the rest is copied. Locations are kept as offsets within tiles if bQuantize
+	 */
+	void BuildFromTiles(const TSharedPtr<const FSpiderNavTiles, ESPMode::ThreadSafe>& InTiles, const TArray<int32>& TileIndexes, const FSpiderNavGraph* Previous, bool bQuantize);
+
+	/** Removes all nodes and edges */
+	void Empty();
+
+	/**
+	 * Replaces locations and normals by compact ones: locations become offsets of QuantizationStep within tiles,
+	 * normals are packed by octahedral encoding into two bytes. Returns false and keeps grid as it is if it has too many tiles
+	 */
+	bool Quantize(float Step);
+
+	/** Whether locations and normals are stored in compact form */
+	FORCEINLINE bool IsQuantized() const
+	{
+		return QuantizedLocations.Num() > 0;
+	}
+
+	/** Returns number of nodes */
+	FORCEINLINE int32 Num() const
+	{
+		return NodesNum;
+	}
+
+	/** Returns location of node */
+	FORCEINLINE FVector GetLocation(int32 Node) const
+	{
+		if (IsQuantized()) {
+			const FSpiderNavQuantizedLocation& Quantized = QuantizedLocations[Node];
+			return TileOrigins[Quantized.Tile] + FVector(Quantized.X, Quantized.Y, Quantized.Z) * QuantizationStep;
+		}
+		return Locations[Node];
+	}
+
+	/** Returns normal of node */
+	FORCEINLINE FVector GetNormal(int32 Node) const
+	{
+		return IsQuantized() ? DecodeNormal(QuantizedNormals[Node]) : Normals[Node];
+	}
+
+	/** Returns memory used by grid and all its indexes in bytes */
+	SIZE_T GetAllocatedSize() const;
+
+	/** Packs unit vector into two bytes by projecting it onto octahedron */
+	static uint16 EncodeNormal(const FVector& Normal);
+
+	/** Unpacks normal packed by EncodeNormal */
+	static FVector DecodeNormal(uint16 Encoded);
+
+	/** Returns the first edge of node */
+	FORCEINLINE int32 GetEdgesBegin(int32 Node) const
+	{
+		return EdgeOffsets[Node];
+	}
+
+	/** Returns the edge after the last edge of node */
+	FORCEINLINE int32 GetEdgesEnd(int32 Node) const
+	{
+		return EdgeOffsets[Node + 1];
+	}
+
+	/** Returns whether path between nodes exists */
+	FORCEINLINE bool IsReachable(int32 From, int32 To) const
+	{
+		return ComponentIds[From] == ComponentIds[To];
+	}
+
+	/** Returns node of component which is the closest to location */
+	int32 FindClosestNodeInComponent(int32 ComponentId, const FVector& Location) const;
+
+	/**
+	 * Returns the closest node to location starting from HintNode which was the closest one before.
+	 * Moves to closer neighbors while there are any. Spatial index is searched only if location has jumped away from HintNode
+	 */
+	int32 FindClosestNodeFromHint(int32 HintNode, const FVector& Location) const;
+
+	/** Returns tile of location if this grid has been built from tiles and there are nodes in that tile, or INDEX_NONE */
+	int32 FindStreamingTile(const FVector& Location) const;
+
+	/** Whether tile of Tiles is in this grid */
+	FORCEINLINE bool IsTileStreamedIn(int32 Tile) const
+	{
+		return TileFirstNodes[Tile] != INDEX_NONE;
+	}
+
+	/** Whether node of grid PreviousId has the same index, location and edges in this grid */
+	FORCEINLINE bool IsNodeKept(int32 PreviousNode) const
+	{
+		return PreviousNode >= 0 && PreviousNode < KeptNodes.Num() && KeptNodes[PreviousNode];
+	}
+
+	/** Locations of nodes. Empty if grid is quantized, use GetLocation */
+	TArray<FVector> Locations;
+
+	/** Normals of nodes from nearest world object with collision. Empty if grid is quantized, use GetNormal */
+	TArray<FVector> Normals;
+
+	/** Locations of nodes of quantized grid */
+	TArray<FSpiderNavQuantizedLocation> QuantizedLocations;
+
+	/** Normals of nodes of quantized grid */
+	TArray<uint16> QuantizedNormals;
+
+	/** Corners of tiles of quantized grid */
+	TArray<FVector> TileOrigins;
+
+	/** Length of one unit of quantized offset */
+	float QuantizationStep;
+
+	/** Edges of node i are in range [EdgeOffsets[i], EdgeOffsets[i + 1]) of EdgeTargets and EdgeCosts */
+	TArray<int32> EdgeOffsets;
+
+	/** Indexes of nodes at the end of edges */
+	TArray<int32> EdgeTargets;
+
+	/** Lengths of edges */
+	TArray<float> EdgeCosts;
+
+	/** Connected component of each node. Edges are symmetric, so nodes of one component are reachable from each other */
+	TArray<int32> ComponentIds;
+
+	/** Nodes of component i are in range [ComponentOffsets[i], ComponentOffsets[i + 1]) of ComponentNodes */
+	TArray<int32> ComponentOffsets;
+
+	/** Indexes of nodes grouped by components */
+	TArray<int32> ComponentNodes;
+
+	/** Index to find closest nodes */
+	FSpiderNavSpatialIndex SpatialIndex;
+
+	/** Clusters for hierarchical search. Empty if grid has been saved without them */
+	FSpiderNavClusters Clusters;
+
+	/** Distances to landmarks for A-star heuristic. Empty if they have not been computed on load */
+	FSpiderNavLandmarks Landmarks;
+
+	/** Contraction hierarchy for fast queries. Empty if grid has been saved without it */
+	FSpiderNavContractionHierarchy ContractionHierarchy;
+
+	/** Tiles of the whole grid if this grid has been built from some of them */
+	TSharedPtr<const FSpiderNavTiles, ESPMode::ThreadSafe> Tiles;
+
+	/** The first node of each of Tiles in this grid or INDEX_NONE if tile is not streamed in. Nodes between ranges of tiles have no edges */
+	TArray<int32> TileFirstNodes;
+
+	/** Id of grid which this one has been stitched from keeping its nodes, or zero */
+	uint32 PreviousId;
+
+	/** Nodes of grid PreviousId which are kept in this grid, so paths and searches over them stay valid */
+	TBitArray<> KeptNodes;
+
+	/** Unique id of built grid. Data computed for one grid is not valid for another */
+	uint32 Id;
+
+protected:
+	int32 NodesNum;
+
+	void ComputeEdgeCosts();
+
+	void BuildSpatialIndex(float GridStepSize);
+
+	void BuildComponents();
+};
+
+/** Shared read-only grid. Queries running on worker threads keep the grid alive while it is replaced by a new one */
+typedef TSharedPtr<const FSpiderNavGraph, ESPMode::ThreadSafe> FSpiderNavGraphPtr;
@@ -0,0 +1,45 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SpiderNavGridData.h"
+#include "SpiderNavGridAsset.generated.h"
+
+/** Navigation grid of one map which is cooked and packaged with it. Grid is stored in the same dense binary form as the file of builder */
+UCLASS(BlueprintType)
+class USpiderNavGridAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/** Grid. Empty if asset has not been written by builder or has been saved with another version of the grid format */
+	FSpiderNavGridData GridData;
+
+	virtual void Serialize(FArchive& Ar) override;
+
+	/** Returns number of navigation points in the grid */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	int32 GetNavNodesCount() const;
+};
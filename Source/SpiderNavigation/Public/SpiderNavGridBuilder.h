@@ -30,6 +30,8 @@
 #include "SpiderNavPoint.h"
 #include "SpiderNavPointEdge.h"
 #include "SpiderNavGridSaveGame.h"
+#include "SpiderNavGridData.h"
+#include "SpiderNavGridAsset.h"
 #include "Kismet/GameplayStatics.h"
 #include "SpiderNavGridBuilder.generated.h"
 
@@ -114,6 +116,30 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavGridBuilder")
 	float EgdeDeviationModificator;
 
+	/** Whether to split grid into clusters for hierarchical search when saving it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavGridBuilder")
+	bool bBuildClusters;
+
+	/** Size of a cubic cluster for hierarchical search. Multiplier of GridStepSize */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavGridBuilder")
+	float ClusterSizeModificator;
+
+	/** Whether to build contraction hierarchy for fast long-range queries when saving grid */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavGridBuilder")
+	bool bBuildContractionHierarchy;
+
+	/** Whether to save grid to save game too. Only old versions of SpiderNavigation need it, new ones read binary file in Saved directory */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavGridBuilder")
+	bool bSaveToSaveGame;
+
+	/** Whether to write grid to GridAsset when playing in editor, so it is cooked with the map */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavGridBuilder")
+	bool bSaveToAsset;
+
+	/** Asset which grid is written to. If it is not set, asset named after the map is created in /Game/SpiderNavigation */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavGridBuilder")
+	TSoftObjectPtr<USpiderNavGridAsset> GridAsset;
+
     /** Whether should try to remove tracers enclosed in volumes */
 	//UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavGridBuilder")
     bool bShouldTryToRemoveTracersEnclosedInVolumes;
@@ -167,6 +193,12 @@ protected:
 
 	int32 GetNavPointIndex(ASpiderNavPoint* NavPoint);
 
+	/** Writes grid in format of old versions of SpiderNavigation */
+	void SaveGridToSaveGame(const FSpiderNavGridData& GridData);
+
+	/** Writes grid to package of GridAsset. Works only in editor */
+	bool SaveGridToAsset(const FSpiderNavGridData& GridData);
+
 	float DebugThickness;
 
 public:	
@@ -181,7 +213,7 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "SpiderNavGridBuilder")
 	void DrawDebugRelations();
 
-    /** Saves navigation grid to save file */
+    /** Saves navigation grid to binary file in Saved directory of project */
 	UFUNCTION(BlueprintCallable, Category = "SpiderNavGridBuilder")
 	void SaveGrid();
 };
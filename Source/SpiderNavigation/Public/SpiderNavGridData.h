@@ -0,0 +1,104 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderNavGridSaveGame.h"
+
+FORCEINLINE FArchive& operator<<(FArchive& Ar, FSpiderNavAbstractEdge& Edge)
+{
+	Ar << Edge.From;
+	Ar << Edge.To;
+	Ar << Edge.Cost;
+	return Ar;
+}
+
+FORCEINLINE FArchive& operator<<(FArchive& Ar, FSpiderNavHierarchyEdge& Edge)
+{
+	Ar << Edge.From;
+	Ar << Edge.To;
+	Ar << Edge.Cost;
+	Ar << Edge.Middle;
+	return Ar;
+}
+
+/**
+ * Navigation grid in dense binary form. Nodes are referenced by their indexes and edges are stored as compressed sparse rows,
+ * so arrays are read from file in bulk without per node lookups. Clusters and contraction hierarchy are empty if grid has been saved without them
+ */
+struct FSpiderNavGridData
+{
+public:
+	FSpiderNavGridData();
+
+	/** GridStepSize of the builder which has built the grid */
+	float GridStepSize;
+
+	/** Locations of nodes */
+	TArray<FVector> Locations;
+
+	/** Normals of nodes */
+	TArray<FVector> Normals;
+
+	/** Edges of node i are in range [EdgeOffsets[i], EdgeOffsets[i + 1]) of EdgeTargets */
+	TArray<int32> EdgeOffsets;
+
+	/** Indexes of nodes at the end of edges */
+	TArray<int32> EdgeTargets;
+
+	/** Cluster of each node */
+	TArray<int32> ClusterIds;
+
+	/** Edges between entrances of clusters */
+	TArray<FSpiderNavAbstractEdge> AbstractEdges;
+
+	/** Order of contraction of each node */
+	TArray<int32> Ranks;
+
+	/** Upward edges and shortcuts of contraction hierarchy */
+	TArray<FSpiderNavHierarchyEdge> HierarchyEdges;
+
+	/** Reads or writes grid. Returns false if archive has another format or version or loaded data is inconsistent */
+	bool Serialize(FArchive& Ar);
+
+	/** Writes grid to file. Returns false if file can not be written */
+	bool SaveToFile(const FString& Filename);
+
+	/** Reads grid from file. Returns false and leaves grid empty if file does not exist or can not be read */
+	bool LoadFromFile(const FString& Filename);
+
+	/** Whether sizes of arrays agree with each other and all indexes point to existing nodes */
+	bool IsValid() const;
+
+	void Empty();
+
+	/** File in Saved directory of project which builder writes grid to */
+	static FString GetDefaultFilename();
+
+protected:
+	/** Marks files of grid */
+	static const uint32 Magic;
+
+	/** Incremented on each change of layout. Files of other versions are not loaded */
+	static const int32 Version;
+};
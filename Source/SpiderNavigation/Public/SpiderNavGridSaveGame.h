@@ -36,6 +36,78 @@ struct FSpiderNavRelations
 	TArray<int32> Neighbors;
 };
 
+/** Edge of abstract graph between entrances of clusters */
+USTRUCT()
+struct FSpiderNavAbstractEdge
+{
+	GENERATED_BODY()
+
+    /** Index of navigation point where edge starts */
+	UPROPERTY()
+	int32 From;
+
+    /** Index of navigation point where edge ends */
+	UPROPERTY()
+	int32 To;
+
+    /** Length of the shortest path between points */
+	UPROPERTY()
+	float Cost;
+
+	FSpiderNavAbstractEdge()
+	{
+		From = -1;
+		To = -1;
+		Cost = 0.0f;
+	}
+
+	FSpiderNavAbstractEdge(int32 InFrom, int32 InTo, float InCost)
+	{
+		From = InFrom;
+		To = InTo;
+		Cost = InCost;
+	}
+};
+
+/** Upward edge of contraction hierarchy from navigation point of lower rank to point of higher rank */
+USTRUCT()
+struct FSpiderNavHierarchyEdge
+{
+	GENERATED_BODY()
+
+    /** Index of navigation point of lower rank */
+	UPROPERTY()
+	int32 From;
+
+    /** Index of navigation point of higher rank */
+	UPROPERTY()
+	int32 To;
+
+    /** Cost of path between points */
+	UPROPERTY()
+	float Cost;
+
+    /** Index of contracted navigation point which shortcut goes through or -1 for edge of grid */
+	UPROPERTY()
+	int32 Middle;
+
+	FSpiderNavHierarchyEdge()
+	{
+		From = -1;
+		To = -1;
+		Cost = 0.0f;
+		Middle = -1;
+	}
+
+	FSpiderNavHierarchyEdge(int32 InFrom, int32 InTo, float InCost, int32 InMiddle)
+	{
+		From = InFrom;
+		To = InTo;
+		Cost = InCost;
+		Middle = InMiddle;
+	}
+};
+
 /**
  *  A USaveGame's extension to store navigation
  */
@@ -57,6 +129,26 @@ public:
 	UPROPERTY()
 	TMap<int32, FSpiderNavRelations> NavRelations;
 
+    /** Clusters of navigation points for hierarchical search */
+	UPROPERTY()
+	TMap<int32, int32> NavClusters;
+
+    /** Edges between entrances of clusters */
+	UPROPERTY()
+	TArray<FSpiderNavAbstractEdge> NavAbstractEdges;
+
+    /** Order of contraction of navigation points */
+	UPROPERTY()
+	TMap<int32, int32> NavRanks;
+
+    /** Upward edges and shortcuts of contraction hierarchy. Downward edges are the same ones reversed */
+	UPROPERTY()
+	TArray<FSpiderNavHierarchyEdge> NavHierarchyEdges;
+
+    /** GridStepSize of the builder which has built the grid */
+	UPROPERTY()
+	float GridStepSize;
+
     /** Name of save slot to store navigation grid */
 	UPROPERTY()
 	FString SaveSlotName;
@@ -0,0 +1,152 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderNavGraph.h"
+
+/**
+ * Persistent search of one agent which is continued instead of restarted when the agent or its goal moves, like Moving Target D* Lite and Fringe-Retrieving A*.
+ * The tree of A-star grows from the node of the agent, so costs in the tree do not depend on the goal. Moved goal only changes heuristic:
+ * keys in open list are kept as lower bounds by adding KeyModifier and are updated lazily, and a goal which is already closed needs no search at all.
+ * Agent which moves along the path keeps the tree. When the path to the goal does not go through the agent anymore, the tree is cut to the subtree
+ * of the agent: costs there only decrease by cost of the agent's node, and the open list is retrieved from neighbors of the kept nodes without expansions
+ */
+struct FSpiderNavIncrementalPlanner
+{
+public:
+	FSpiderNavIncrementalPlanner();
+
+	/**
+	 * Returns the next node on the shortest path from start node to end node or INDEX_NONE if end is not reachable
+	 * or the tree would need more than MaxNodesNum nodes. Zero MaxNodesNum means no limit
+	 */
+	int32 FindNextNode(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, int32 MaxNodesNum = 0);
+
+	/** Forgets previous search and frees its memory */
+	void Reset();
+
+	/**
+	 * Moves the tree to grid NewGraphId stitched from grid which it has been built on. Kept nodes have the same edges, so the tree stays valid,
+	 * otherwise it is dropped and rebuilt by the next FindNextNode
+	 */
+	void Rebase(uint32 OldGraphId, uint32 NewGraphId, TFunctionRef<bool(int32)> IsNodeKept);
+
+	/** Returns number of nodes kept in the tree and in its open list */
+	FORCEINLINE int32 Num() const
+	{
+		return Nodes.Num();
+	}
+
+	/** Number of nodes expanded by the last call of FindNextNode */
+	int32 ExpandedNodesNum;
+
+	/** Number of nodes kept by cutting the tree in the last call of FindNextNode. They are not expanded again */
+	int32 KeptNodesNum;
+
+protected:
+	/** Search state of node touched by the planner. Node which is not closed is in open list */
+	struct FPlannerNode
+	{
+		int32 Index;
+		/** Cost of path from the root to the node */
+		float G;
+		float Key;
+		/** Slot of the previous node on the path from the root */
+		int32 ParentSlot;
+		int32 HeapIndex;
+		bool bClosed;
+	};
+
+	/** Frees the old tree and starts a new one from node of the agent */
+	void Restart(const FSpiderNavGraph& NavGraph, int32 InRootIndex);
+
+	/** Keeps closed nodes of subtree of node of the agent and makes it the root. Neighbors of kept nodes become open list */
+	void CutTree(const FSpiderNavGraph& NavGraph);
+
+	/** Continues search until the goal is closed. Returns false if it is not reachable or the tree has grown over MaxNodesNum */
+	bool Search(const FSpiderNavGraph& NavGraph, int32 MaxNodesNum);
+
+	/** Returns the node after the agent on the path from the root to the goal or INDEX_NONE if the path does not go through the agent */
+	int32 FindNodeAfterStart() const;
+
+	/** Returns slot of node or INDEX_NONE if the node has not been touched */
+	int32 FindSlot(int32 Index) const;
+
+	/** Returns slot of node, adds it if the node has not been touched yet. Sets bAdded then */
+	int32 GetSlot(int32 Index, bool& bAdded);
+
+	/** Makes table of slots big enough for Nodes and puts all of them there */
+	void RebuildSlots(int32 NodesNum);
+
+	FORCEINLINE uint32 GetSlotsPosition(int32 Index) const
+	{
+		// Fibonacci hashing spreads close indexes of neighbors over the table
+		return ((uint32)Index * 2654435769u) >> (32 - SlotsBits);
+	}
+
+	FORCEINLINE float GetKey(const FSpiderNavGraph& NavGraph, const FPlannerNode& Node) const
+	{
+		return Node.G + (NavGraph.GetLocation(Node.Index) - GoalLocation).Size() + KeyModifier;
+	}
+
+	void PushOpenSlot(int32 Slot);
+
+	void SiftUp(int32 Position);
+
+	void SiftDown(int32 Position);
+
+	/** States of touched nodes. Agents search small parts of grid, so states are not kept for all nodes */
+	TArray<FPlannerNode> Nodes;
+
+	/** Open addressing table of slots in Nodes by index of node, INDEX_NONE marks free position. Its size is a power of two */
+	TArray<int32> SlotsTable;
+
+	int32 SlotsBits;
+
+	/** Binary heap of slots ordered by Key */
+	TArray<int32> OpenList;
+
+	/** Slots of kept nodes while the tree is cut. Kept between calls to reuse its memory */
+	TArray<int32> KeptSlots;
+
+	/** Id of grid which the tree has been built on */
+	uint32 GraphId;
+
+	/** Root of the tree */
+	int32 RootIndex;
+
+	/** Node of the agent */
+	int32 StartIndex;
+
+	/** Node which heuristic is computed to */
+	int32 GoalIndex;
+
+	FVector GoalLocation;
+
+	/** Sum of distances which the goal has moved by since keys have been computed */
+	float KeyModifier;
+
+	/** Distance between the agent and the goal when the tree has grown over the limit. Farther goals are not searched by the planner */
+	float OverLimitDistance;
+};
@@ -0,0 +1,101 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FSpiderNavGraph;
+
+/**
+ * Distances from every node to a few landmark nodes. By triangle inequality |d(L, a) - d(L, b)| <= d(a, b),
+ * which gives a much tighter lower bound of path cost than straight line when path goes around walls and ceilings
+ */
+struct FSpiderNavLandmarks
+{
+public:
+	FSpiderNavLandmarks();
+
+	/** Chooses landmarks far from each other and runs Dijkstra from each of them. Edges of grid are expected to be symmetric */
+	void Build(const FSpiderNavGraph& NavGraph, int32 InLandmarksNum);
+
+	/** Copies distances of NodesNum nodes starting from SourceFirstNode of landmarks built on bigger grid, e.g. on the whole grid for its streamed part,
+	 * to nodes starting from FirstNode. Paths in part of grid are not shorter than in the whole one, so bounds stay admissible */
+	void CopyNodes(const FSpiderNavLandmarks& Source, int32 SourceFirstNode, int32 FirstNode, int32 NodesNum);
+
+	/** Drops distances of nodes after NodesNum or adds unreachable ones up to it */
+	void SetNodesNum(int32 NodesNum);
+
+	void Empty();
+
+	/** Whether landmarks have been built */
+	FORCEINLINE bool IsEmpty() const
+	{
+		return LandmarksNum == 0;
+	}
+
+	/**
+	 * Returns lower bound of cost of path between nodes. Never overestimates, but rounding makes it inconsistent:
+	 * bounds of neighbors can differ by up to two steps more than cost of edge between them, so A-star reopens closed nodes with it
+	 */
+	FORCEINLINE float GetLowerBound(int32 From, int32 To) const
+	{
+		const uint16* FromDistances = &Distances[From * LandmarksNum];
+		const uint16* ToDistances = &Distances[To * LandmarksNum];
+		int32 MaxDifference = 0;
+		for (int32 i = 0; i < LandmarksNum; i++) {
+			if (FromDistances[i] != UnreachableDistance && ToDistances[i] != UnreachableDistance) {
+				MaxDifference = FMath::Max(MaxDifference, FMath::Abs((int32)FromDistances[i] - (int32)ToDistances[i]));
+			}
+		}
+		// each distance is rounded to the closest step, so the difference can be one step more than exact one
+		return FMath::Max(MaxDifference - 1, 0) * QuantStep;
+	}
+
+	/** Returns memory used by distances in bytes */
+	FORCEINLINE int32 GetAllocatedSize() const
+	{
+		return Distances.GetAllocatedSize();
+	}
+
+	/** Returns number of landmarks */
+	FORCEINLINE int32 Num() const
+	{
+		return LandmarksNum;
+	}
+
+	/** Nodes of grid chosen as landmarks. Empty for distances copied from another grid */
+	TArray<int32> LandmarkNodes;
+
+protected:
+	/** Marks node which can not be reached from landmark */
+	static const uint16 UnreachableDistance = MAX_uint16;
+
+	/** Number of landmarks */
+	int32 LandmarksNum;
+
+	/** Cost of path which one unit of quantized distance stands for */
+	float QuantStep;
+
+	/** Quantized distances. Distances of node i to all landmarks are in range [i * LandmarksNum, (i + 1) * LandmarksNum) */
+	TArray<uint16> Distances;
+};
@@ -0,0 +1,103 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/** Thread safe LRU cache of paths between nodes of one grid */
+class FSpiderNavPathCache
+{
+public:
+	FSpiderNavPathCache();
+
+	/** Sets maximum number of cached paths. Zero disables cache */
+	void SetCapacity(int32 InCapacity);
+
+	/** Removes all paths. Only paths of grid with GraphId are accepted after that */
+	void Invalidate(uint32 InGraphId);
+
+	/**
+	 * Moves paths to grid NewGraphId stitched from grid OldGraphId. Paths through nodes which are not kept there are removed,
+	 * so are partial paths, they can be completed in new grid. Order of usage and statistics are kept
+	 */
+	void Rebase(uint32 OldGraphId, uint32 NewGraphId, TFunctionRef<bool(int32)> IsNodeKept);
+
+	/**
+	 * Copies cached path between nodes to OutPath. A suffix of a cached complete path is also an optimal path, so it is used too.
+	 * Returns false if there is no such path
+	 */
+	bool Find(uint32 InGraphId, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bOutFoundCompletePath);
+
+	/** Adds path between nodes. The least recently used path is removed when cache is full and its memory is reused for the new one */
+	void Add(uint32 InGraphId, int32 StartIndex, int32 EndIndex, const TArray<int32>& Path, bool bFoundCompletePath);
+
+	/** Returns statistics of cache */
+	void GetStats(int32& OutHitsNum, int32& OutMissesNum, int32& OutPathsNum);
+
+protected:
+	struct FEntry
+	{
+		int32 StartIndex;
+		int32 EndIndex;
+		TArray<int32> Path;
+		bool bFoundCompletePath;
+
+		/** Neighbors in the list of entries ordered by usage */
+		int32 Newer;
+		int32 Older;
+	};
+
+	static uint64 MakeKey(int32 StartIndex, int32 EndIndex)
+	{
+		return ((uint64)(uint32)StartIndex << 32) | (uint32)EndIndex;
+	}
+
+	/** Moves entry to the head of usage list */
+	void Touch(int32 Entry);
+
+	void Unlink(int32 Entry);
+
+	void LinkAsNewest(int32 Entry);
+
+	void Clear();
+
+	FCriticalSection Lock;
+
+	int32 Capacity;
+
+	uint32 GraphId;
+
+	TArray<FEntry> Entries;
+
+	TMap<uint64, int32> EntriesByKey;
+
+	/** Complete paths by their end node to look up suffixes */
+	TMultiMap<int32, int32> CompleteEntriesByEndNode;
+
+	int32 Newest;
+	int32 Oldest;
+
+	int32 HitsNum;
+	int32 MissesNum;
+};
@@ -0,0 +1,151 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+/** A-star metrics of one node. Valid only while Generation equals the generation of its search context */
+struct FSpiderNavSearchNode
+{
+	/** F-value of node from A-star */
+	float F;
+
+	/** G-value of node from A-star */
+	float G;
+
+	/** Index (id) of parent node from A-star */
+	int32 ParentIndex;
+
+	/** Position of node in open list or INDEX_NONE if node is not there */
+	int32 HeapIndex;
+
+	/** Generation of search which has touched the node last time */
+	uint32 Generation;
+
+	/** Opened property of node from A-star */
+	bool bOpened;
+
+	/** Closed propery of node from A-star */
+	bool bClosed;
+};
+
+/** Scratch memory of one path query. Can be reused by the next query without walking all nodes */
+struct FSpiderNavSearchContext
+{
+public:
+	FSpiderNavSearchContext();
+
+	/** Prepares context for a new search over grid with NodesNum nodes */
+	void Reset(int32 NodesNum);
+
+	/** Returns metrics of node, initializes them if node was not touched by current search yet */
+	FORCEINLINE FSpiderNavSearchNode& GetNode(int32 Index)
+	{
+		FSpiderNavSearchNode& Node = Nodes[Index];
+		if (Node.Generation != Generation) {
+			Node.F = 0.0f;
+			Node.G = 0.0f;
+			Node.ParentIndex = -1;
+			Node.HeapIndex = INDEX_NONE;
+			Node.Generation = Generation;
+			Node.bOpened = false;
+			Node.bClosed = false;
+		}
+		return Node;
+	}
+
+	/** Returns metrics of node or nullptr if node was not touched by current search */
+	FORCEINLINE const FSpiderNavSearchNode* FindNode(int32 Index) const
+	{
+		const FSpiderNavSearchNode& Node = Nodes[Index];
+		return Node.Generation == Generation ? &Node : nullptr;
+	}
+
+	/** Whether open list has nodes */
+	FORCEINLINE bool HasOpenNodes() const
+	{
+		return OpenList.Num() > 0;
+	}
+
+	/** Returns index of node with the lowest F-value without removing it from open list */
+	FORCEINLINE int32 PeekOpenNode() const
+	{
+		return OpenList[0];
+	}
+
+	/** Adds touched node to open list */
+	void PushOpenNode(int32 Index);
+
+	/** Restores order of open list after F-value of opened node has been decreased */
+	void DecreaseOpenNode(int32 Index);
+
+	/** Removes node with the lowest F-value from open list and returns its index */
+	int32 PopOpenNode();
+
+	/** Number of nodes popped from open list during current search */
+	int32 ExpandedNodesNum;
+
+	/** Buffers of hierarchical search. Kept with the context, so repeated queries reuse their memory */
+	TArray<TPair<int32, float>> StartEntrances;
+	TArray<TPair<int32, float>> EndEntrances;
+	TArray<int32> AbstractPath;
+	TBitArray<> Corridor;
+
+	/** Buffers of search over contraction hierarchy. Path over upward edges and stack of edges which are being unpacked */
+	TArray<int32> HierarchyPath;
+	TArray<TPair<int32, int32>> UnpackStack;
+
+protected:
+	/** Moves node at Position up to the root while its F-value is lower than parent's one */
+	void SiftUp(int32 Position);
+
+	/** Moves node at Position down to leaves while its F-value is greater than children's ones */
+	void SiftDown(int32 Position);
+
+	/** Open list of A-star. 4-ary heap of indexes of nodes ordered by F-value */
+	TArray<int32> OpenList;
+
+	TArray<FSpiderNavSearchNode> Nodes;
+
+	uint32 Generation;
+};
+
+/** Thread safe pool of search contexts */
+class FSpiderNavSearchContextPool
+{
+public:
+	/** Returns free context or creates a new one */
+	TUniquePtr<FSpiderNavSearchContext> Acquire();
+
+	/** Returns context to the pool for the next queries */
+	void Release(TUniquePtr<FSpiderNavSearchContext> Context);
+
+	/** Frees memory of all contexts in the pool */
+	void Empty();
+
+protected:
+	FCriticalSection Lock;
+
+	TArray<TUniquePtr<FSpiderNavSearchContext>> FreeContexts;
+};
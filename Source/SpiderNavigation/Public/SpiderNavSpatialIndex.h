@@ -0,0 +1,169 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Uniform hash grid over navigation nodes. Answers closest node queries without scanning the whole grid */
+struct FSpiderNavSpatialIndex
+{
+public:
+	FSpiderNavSpatialIndex();
+
+	/** Builds index over locations of nodes. Location with index i belongs to node i */
+	void Build(const TArray<FVector>& Locations, float InCellSize);
+
+	/** Removes all nodes from index and sets size of cells for AddNodes */
+	void Init(float InCellSize);
+
+	/** Copies nodes of another index for which Filter returns true. Their offsets are copied, so they are not quantized again */
+	void CopyFrom(const FSpiderNavSpatialIndex& Source, TFunctionRef<bool(int32)> Filter);
+
+	/**
+	 * Adds nodes with indexes starting from FirstNode. Their cells are appended after all nodes,
+	 * cells which already have nodes are moved there too and leave unused slots until the index is copied
+	 */
+	void AddNodes(const TArray<FVector>& Locations, int32 FirstNode);
+
+	/** Removes all nodes from index */
+	void Empty();
+
+	/** Returns index of the closest node to location or INDEX_NONE if index is empty */
+	int32 FindClosest(const FVector& Location) const;
+
+	/** Returns index of the closest node to location for which Filter returns true or INDEX_NONE if there is no such node */
+	int32 FindClosest(const FVector& Location, TFunctionRef<bool(int32)> Filter) const;
+
+	/** Finds the closest node for each location. Locations in the same cell are searched together, so each node of cells around them is loaded once for all of them */
+	void FindClosest(const TArray<FVector>& Locations, TArray<int32>& OutNodes) const;
+
+	/** Finds up to Count closest nodes to location. Nodes are sorted by distance */
+	void FindClosest(const FVector& Location, int32 Count, TArray<int32>& OutNodes) const;
+
+	/** Returns size of cell's edge */
+	float GetCellSize() const { return CellSize; }
+
+	/** Returns memory used by index in bytes */
+	int32 GetAllocatedSize() const
+	{
+		return Cells.GetAllocatedSize() + SortedNodes.GetAllocatedSize() + SortedX.GetAllocatedSize() + SortedY.GetAllocatedSize() + SortedZ.GetAllocatedSize();
+	}
+
+protected:
+	/** Range of nodes in SortedNodes which belong to a cell */
+	struct FCell
+	{
+		int32 First;
+		int32 Num;
+
+		FCell()
+		{
+			First = 0;
+			Num = 0;
+		}
+	};
+
+	FIntVector GetCellCoord(const FVector& Location) const;
+
+	/** Extends bounds of occupied cells by cell */
+	void AddToBounds(const FIntVector& Coord);
+
+	/** Writes node and its offsets from origin of cell Coord to slot */
+	void SetSlot(int32 Slot, int32 Node, const FVector& Location, const FIntVector& Coord);
+
+	/** Returns number of the first and the last rings of cells around Center which can contain nodes */
+	void GetRingsRange(const FIntVector& Center, int32& OutFirstRing, int32& OutLastRing) const;
+
+	/** Searches rings of cells around location until no closer node can be found */
+	template <typename FilterType>
+	int32 FindClosestFiltered(const FVector& Location, FilterType Filter) const;
+
+	/** Returns the corner of cell which offsets of its nodes are measured from */
+	FORCEINLINE FVector GetCellOrigin(const FIntVector& Coord) const
+	{
+		return FVector(Coord) * CellSize;
+	}
+
+	/** Returns location relative to the corner of cell in units of OffsetStep, which offsets of nodes are compared with without scaling */
+	FORCEINLINE FVector GetLocalOffsets(const FVector& Location, const FIntVector& Coord) const
+	{
+		return (Location - GetCellOrigin(Coord)) * InvOffsetStep;
+	}
+
+	/** Returns offset of node in slot from the origin of its cell along one axis */
+	FORCEINLINE float GetOffset(const TArray<uint16>& SortedOffsets, int32 Slot) const
+	{
+		return SortedOffsets[Slot] * OffsetStep;
+	}
+
+	/** Returns offsets of four nodes starting from slot along one axis in units of OffsetStep. 16-bit lanes are loaded at once and widened in the register */
+	FORCEINLINE VectorRegister LoadOffsets(const TArray<uint16>& SortedOffsets, int32 Slot) const
+	{
+		const uint16* Offsets = &SortedOffsets[Slot];
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+		return vcvtq_f32_u32(vmovl_u16(vld1_u16(Offsets)));
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)Offsets), _mm_setzero_si128()));
+#else
+		return MakeVectorRegister((float)Offsets[0], (float)Offsets[1], (float)Offsets[2], (float)Offsets[3]);
+#endif
+	}
+
+	/**
+	 * Checks nodes of one cell in range [First, Last) of slots, four at once, and updates the closest slot.
+	 * LocalOffsets is location relative to origin of the cell in units of OffsetStep, distances are measured in these units too
+	 */
+	template <typename FilterType>
+	void ScanSlots(int32 First, int32 Last, const FVector& LocalOffsets, FilterType& Filter, int32& BestSlot, float& BestDistanceSquared) const;
+
+	/** Does the same as ScanSlots for LocationsNum locations at once. Each group of four nodes is loaded once and compared with all locations */
+	void ScanSlotsForLocations(int32 First, int32 Last, const FVector* LocalOffsets, int32 LocationsNum, int32* BestSlots, float* BestDistancesSquared) const;
+
+	/** Calls Visitor with each non-empty cell and its coordinates which lie on the surface of the cube with half-size Ring around Center */
+	template <typename VisitorType>
+	void ForEachCellInRing(const FIntVector& Center, int32 Ring, VisitorType Visitor) const;
+
+	float CellSize;
+	float InvCellSize;
+
+	/** Length which one unit of offset inside of cell stands for. Cell is MAX_uint16 units long */
+	float OffsetStep;
+	float InvOffsetStep;
+
+	/** Bounds of occupied cells */
+	FIntVector MinCoord;
+	FIntVector MaxCoord;
+
+	TMap<FIntVector, FCell> Cells;
+
+	/** Indexes of nodes grouped by cells */
+	TArray<int32> SortedNodes;
+
+	/**
+	 * Coordinates of nodes in the same order as SortedNodes as 16-bit offsets from origins of their cells, 6 bytes per node.
+	 * Kept in separate arrays, so four nodes are loaded into one vector register
+	 */
+	TArray<uint16> SortedX;
+	TArray<uint16> SortedY;
+	TArray<uint16> SortedZ;
+};
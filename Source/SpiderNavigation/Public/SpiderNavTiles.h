@@ -0,0 +1,154 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderNavGridData.h"
+#include "SpiderNavLandmarks.h"
+
+/** Location of node of tile as 16-bit offsets from corner of its tile */
+struct FSpiderNavTileLocation
+{
+	uint16 X;
+
+	uint16 Y;
+
+	uint16 Z;
+};
+
+/** Pair of components of neighboring tiles which are connected by at least one edge */
+struct FSpiderNavTileLink
+{
+	/** Component of the tile which the link belongs to */
+	int32 Component;
+
+	int32 NeighborTile;
+
+	int32 NeighborComponent;
+};
+
+/**
+ * Grid split into cubic tiles for streaming, kept in compact form for the whole game. Nodes of each tile are contiguous and sorted by tiles,
+ * edges keep these sorted indexes. Runtime grid is stitched from streamed tiles by FSpiderNavGraph::BuildFromTiles
+ */
+struct FSpiderNavTiles
+{
+public:
+	FSpiderNavTiles();
+
+	/**
+	 * Groups nodes of grid into tiles with edge InTileSize, quantizes them and labels components inside of each tile.
+	 * Clusters and contraction hierarchy are dropped, they are not valid for parts of grid
+	 */
+	void Build(FSpiderNavGridData&& InGridData, float InTileSize);
+
+	/** Computes landmarks on the whole grid, so streamed parts of it copy distances instead of running Dijkstra again */
+	void BuildLandmarks(int32 LandmarksNum);
+
+	/** Returns tile which contains location or INDEX_NONE if there are no nodes there */
+	int32 FindTile(const FVector& Location) const;
+
+	/** Returns tile of node */
+	int32 FindNodeTile(int32 Node) const;
+
+	/** Returns squared distance from location to the closest point of tile */
+	float GetDistanceSquaredToTile(int32 Tile, const FVector& Location) const;
+
+	/** Returns memory used by tiles in bytes */
+	SIZE_T GetAllocatedSize() const;
+
+	/** Returns number of tiles */
+	FORCEINLINE int32 Num() const
+	{
+		return TileCoords.Num();
+	}
+
+	/** Returns number of nodes in tile */
+	FORCEINLINE int32 GetNodesNum(int32 Tile) const
+	{
+		return NodeOffsets[Tile + 1] - NodeOffsets[Tile];
+	}
+
+	/** Returns corner of tile which offsets of its nodes are measured from */
+	FORCEINLINE FVector GetTileOrigin(int32 Tile) const
+	{
+		return FVector(TileCoords[Tile]) * TileSize;
+	}
+
+	/** Returns location of node of tile */
+	FORCEINLINE FVector GetLocation(int32 Tile, int32 Node) const
+	{
+		const FSpiderNavTileLocation& Location = Locations[Node];
+		return GetTileOrigin(Tile) + FVector(Location.X, Location.Y, Location.Z) * QuantizationStep;
+	}
+
+	/** Length of edge of tile */
+	float TileSize;
+
+	/** Length of one unit of offset of node inside of its tile */
+	float QuantizationStep;
+
+	/** Size of cells of spatial index of grids stitched from tiles */
+	float CellSize;
+
+	/** Nodes of tile i are in range [NodeOffsets[i], NodeOffsets[i + 1]) */
+	TArray<int32> NodeOffsets;
+
+	/** Locations of nodes */
+	TArray<FSpiderNavTileLocation> Locations;
+
+	/** Normals of nodes packed by FSpiderNavGraph::EncodeNormal */
+	TArray<uint16> Normals;
+
+	/** Edges of node i are in range [EdgeOffsets[i], EdgeOffsets[i + 1]) of EdgeTargets */
+	TArray<int32> EdgeOffsets;
+
+	/** Nodes at the end of edges. Edges to other tiles are dropped when these tiles are not streamed in */
+	TArray<int32> EdgeTargets;
+
+	/** Components of tile i, which are connected by edges inside of it, are in range [ComponentOffsets[i], ComponentOffsets[i + 1]) */
+	TArray<int32> ComponentOffsets;
+
+	/** Component of tile of each node */
+	TArray<int32> NodeComponents;
+
+	/** Links of tile i are in range [LinkOffsets[i], LinkOffsets[i + 1]) of Links */
+	TArray<int32> LinkOffsets;
+
+	/** Components of neighboring tiles which are connected by edges, each pair once for each of both tiles */
+	TArray<FSpiderNavTileLink> Links;
+
+	/** Coordinates of tiles in units of TileSize */
+	TArray<FIntVector> TileCoords;
+
+	/** Tile indexes by their coordinates */
+	TMap<FIntVector, int32> TilesByCoords;
+
+	/** Landmarks of the whole grid or empty ones if they are not used */
+	FSpiderNavLandmarks Landmarks;
+
+protected:
+	FIntVector GetTileCoords(const FVector& Location) const;
+};
+
+typedef TSharedPtr<const FSpiderNavTiles, ESPMode::ThreadSafe> FSpiderNavTilesPtr;
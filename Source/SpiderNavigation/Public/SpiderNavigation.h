@@ -22,93 +22,233 @@
 
 #pragma once
 
-#include <algorithm>
-#include <vector>         // std::vector
 #include "DrawDebugHelpers.h"
 #include "GameFramework/Actor.h"
 #include "SpiderNavGridSaveGame.h"
+#include "SpiderNavGridData.h"
+#include "SpiderNavGridAsset.h"
+#include "Engine/StreamableManager.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavTiles.h"
+#include "SpiderNavSearchContext.h"
+#include "SpiderNavPathCache.h"
+#include "SpiderNavFlowField.h"
+#include "SpiderNavIncrementalPlanner.h"
 #include "Kismet/GameplayStatics.h"
 #include "SpiderNavigation.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(SpiderNAV_LOG, Log, All);
 
-/** Describes navigation point in grid */
-USTRUCT()
-struct FSpiderNavNode
+/** Algorithm used to find path between nodes */
+UENUM(BlueprintType)
+enum class ESpiderNavSearchMode : uint8
 {
-	GENERATED_BODY()
+	/** A-star over the whole grid */
+	AStar,
 
-    /** Location of node */
-	UPROPERTY()
-	FVector Location;
+	/** A-star over abstract graph of clusters, then A-star limited by clusters of abstract path. Needs grid saved with clusters */
+	Hierarchical,
 
-    /** Normal of node from nearest world object with collision */
-	UPROPERTY()
-	FVector Normal;
+	/** Bidirectional search over upward edges of contraction hierarchy. Needs grid saved with contraction hierarchy */
+	ContractionHierarchy,
 
-    /** Index (id) of node */
-	UPROPERTY()
-	int32 Index;
+	/** A-star from both start and end nodes at once. Explores smaller area around start for long paths */
+	Bidirectional
+};
 
-    /** Relations */
-	TArray <FSpiderNavNode*> Neighbors;
+/** Lower bound of path cost used by A-star */
+UENUM(BlueprintType)
+enum class ESpiderNavHeuristic : uint8
+{
+	/** Straight line distance to the end node */
+	Euclidean,
 
-    /** F-value of node from A-star */
-	float F;
+	/** The best of straight line distance and bound from distances to landmarks. Landmarks are computed on load */
+	Landmarks
+};
 
-	/** G-value of node from A-star */
-	float G;
+/** How locations and normals of nodes are kept in memory. Spatial index keeps 16-bit offsets of nodes within its cells in both modes, 10 bytes per node with index of node */
+UENUM(BlueprintType)
+enum class ESpiderNavStorageMode : uint8
+{
+	/** Full precision vectors of three floats, 12 bytes for location and 12 bytes for normal */
+	Full,
 
-	/** H-value of node from A-star */
-	float H;
+	/** 16-bit offsets within tiles and octahedral normals, 8 bytes for location and 2 bytes for normal */
+	Quantized
+};
 
-	/** Opened property of node from A-star */
-	bool Opened;
+/** Path found for one agent of batched query */
+USTRUCT(BlueprintType)
+struct FSpiderNavPath
+{
+	GENERATED_BODY()
 
-	/** Closed propery of node from A-star */
-	bool Closed;
+    /** Locations of nodes of path */
+	UPROPERTY(BlueprintReadOnly, Category = "SpiderNavigation")
+	TArray<FVector> Locations;
 
-	/** Index (id) of parent node from A-star */
-	int32 ParentIndex;
+    /** Whether path reaches the closest node to target */
+	UPROPERTY(BlueprintReadOnly, Category = "SpiderNavigation")
+	bool bFoundCompletePath;
 
-    /** Initialization of node */
-	FSpiderNavNode()
+	FSpiderNavPath()
 	{
-		Location = FVector(0.0f, 0.0f, 0.0f);
-		Index = -1;
-		F = 0.0f;
-		G = 0.0f;
-		H = 0.0f;
-		Opened = false;
-		Closed = false;
-		ParentIndex = -1;
-
-		Neighbors.Empty();
+		bFoundCompletePath = false;
 	}
+};
+
+/** Closest node to location of an agent. Next update of the handle checks only neighbors of this node */
+USTRUCT(BlueprintType)
+struct FSpiderNavLocationHandle
+{
+	GENERATED_BODY()
+
+    /** Closest node to location of the last update or INDEX_NONE */
+	UPROPERTY(BlueprintReadOnly, Category = "SpiderNavigation")
+	int32 NodeIndex;
+
+    /** Id of grid which NodeIndex belongs to */
+	uint32 GraphId;
+
+	FSpiderNavLocationHandle()
+	{
+		NodeIndex = INDEX_NONE;
+		GraphId = 0;
+	}
+};
+
+/** Called on the game thread when asynchronous path query is finished */
+DECLARE_DYNAMIC_DELEGATE_ThreeParams(FSpiderNavPathQueryDelegate, int32, QueryId, const TArray<FVector>&, Path, bool, bFoundCompletePath);
+
+/** Called on the game thread when asynchronous query of the next location is finished */
+DECLARE_DYNAMIC_DELEGATE_FourParams(FSpiderNavNextLocationQueryDelegate, int32, QueryId, bool, bFound, FVector, NextLocation, FVector, Normal);
+
+/** Called on the game thread when loading of grid is finished. bLoaded is false if there is no saved grid */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FSpiderNavGridReadyDelegate, bool, bLoaded);
+
+/** State of A-star between steps. Lets search be continued in the next frame */
+struct FSpiderNavAStarState
+{
+	int32 StartIndex;
+
+	int32 EndIndex;
+
+	/** End node of the query. It differs from EndIndex when the end has been replaced, and found paths are cached by it */
+	int32 RequestedEndIndex;
+
+	FVector EndLocation;
+
+	/** Landmarks for heuristic or nullptr */
+	const FSpiderNavLandmarks* Landmarks;
 
-    /** Resets metriks of A-star */
-	void ResetMetrics()
+	/** Clusters which search does not leave or nullptr */
+	const TBitArray<>* AllowedClusters;
+
+	/** Closed node with the lowest F-value for the case when complete path does not exist */
+	int32 ClosestIndex;
+
+	float ClosestF;
+
+	/** Whether end node has been closed */
+	bool bFoundEnd;
+
+	/** Whether end is not reachable and has been replaced by the closest reachable node to it */
+	bool bEndReplaced;
+
+	FSpiderNavAStarState()
 	{
-		F = 0.0f;
-		G = 0.0f;
-		H = 0.0f;
-		Opened = false;
-		Closed = false;
-		ParentIndex = -1;
+		StartIndex = INDEX_NONE;
+		EndIndex = INDEX_NONE;
+		RequestedEndIndex = INDEX_NONE;
+		EndLocation = FVector::ZeroVector;
+		Landmarks = nullptr;
+		AllowedClusters = nullptr;
+		ClosestIndex = INDEX_NONE;
+		ClosestF = MAX_flt;
+		bFoundEnd = false;
+		bEndReplaced = false;
 	}
 };
 
-/** Comparator < of nodes by F-value */
-struct LessThanByNodeF {
-	bool operator()(const FSpiderNavNode* lhs, const FSpiderNavNode* rhs) const {
-		return lhs->F > rhs->F;
+/** Settings of building grid. Copied on the game thread, so workers do not read properties which Blueprints can change meanwhile */
+struct FSpiderNavBuildSettings
+{
+	bool bStreamTiles;
+
+	float StreamingTileSize;
+
+	float StreamingMemoryBudgetMB;
+
+	ESpiderNavSearchMode SearchMode;
+
+	ESpiderNavHeuristic HeuristicMode;
+
+	int32 LandmarksNum;
+
+	ESpiderNavStorageMode StorageMode;
+
+	float QuantizationStep;
+};
+
+/** Path query which is processed in Tick within budget of frame */
+struct FSpiderNavTimeSlicedQuery
+{
+	int32 QueryId;
+
+	/** Grid which the query has been started on */
+	FSpiderNavGraphPtr Graph;
+
+	/** Search context kept between frames */
+	TUniquePtr<FSpiderNavSearchContext> Context;
+
+	FSpiderNavAStarState State;
+
+	/** Whether path is known without search */
+	bool bFinished;
+
+	/** Path taken from cache when bFinished */
+	TArray<int32> NodesPath;
+
+	bool bFoundCompletePath;
+
+	/** Whether tile of end location is streamed in. Path is partial otherwise */
+	bool bEndStreamedIn;
+
+	FSpiderNavPathQueryDelegate OnPathFound;
+
+	FSpiderNavTimeSlicedQuery()
+	{
+		QueryId = 0;
+		bFinished = false;
+		bFoundCompletePath = false;
+		bEndStreamedIn = true;
 	}
 };
 
-/**  Comparator < of nodes by H-value */
-struct LessThanByNodeH {
-	bool operator()(const FSpiderNavNode* lhs, const FSpiderNavNode* rhs) const {
-		return lhs->H > rhs->H;
+/** Path query of RequestPath waiting for Tick. Requests with the same nodes share one search */
+struct FSpiderNavPathRequest
+{
+	int32 QueryId;
+
+	/** Grid which nodes have been resolved on */
+	FSpiderNavGraphPtr Graph;
+
+	int32 StartIndex;
+
+	int32 EndIndex;
+
+	/** Whether tile of end location is streamed in. Path is partial otherwise */
+	bool bEndStreamedIn;
+
+	FSpiderNavPathQueryDelegate OnPathFound;
+
+	FSpiderNavPathRequest()
+	{
+		QueryId = 0;
+		StartIndex = INDEX_NONE;
+		EndIndex = INDEX_NONE;
+		bEndStreamedIn = true;
 	}
 };
 
@@ -117,35 +257,251 @@ UCLASS()
 class ASpiderNavigation : public AActor
 {
 	GENERATED_BODY()
+
+	/** Follows cached paths, so it reads nodes of the grid directly */
+	friend class USpiderPathFollowingComponent;
 	
 public:	
 	// Sets default values for this actor's properties
 	ASpiderNavigation();
 
+	// Waits for asynchronous queries which use this actor
+	virtual bool IsReadyForFinishDestroy() override;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	TArray<FSpiderNavNode> NavNodes;
-	// SavedIndex -> LocalIndex
-	TMap<int32, int32> NodesSavedIndexes;
+	/** Navigation grid. Replaced as a whole on loading, streamed grid keeps nodes of tiles which stay streamed in */
+	FSpiderNavGraphPtr Graph;
 
-	
+	/** Scratch memory for path queries */
+	FSpiderNavSearchContextPool SearchContexts;
+
+	/** Scratch memory for searches on abstract graph of clusters. Kept apart, so contexts of both pools keep their sizes */
+	FSpiderNavSearchContextPool AbstractSearchContexts;
+
+	/** Recently found paths */
+	FSpiderNavPathCache PathCache;
+
+	/** Recently used flow fields, the most recent one is the last. Fields are moved to new streamed grid under the lock */
+	TArray<TSharedPtr<FSpiderNavFlowField, ESPMode::ThreadSafe>> FlowFields;
+
+	FCriticalSection FlowFieldsLock;
+
+	/** Persistent searches of agents for FindNextLocationAndNormalForAgent. Used only on the game thread */
+	TMap<TWeakObjectPtr<AActor>, TUniquePtr<FSpiderNavIncrementalPlanner>> AgentPlanners;
+
+	/** Queries of FindPathTimeSliced which have not been finished yet */
+	TArray<TUniquePtr<FSpiderNavTimeSlicedQuery>> TimeSlicedQueries;
+
+	/** Time-sliced query which gets the budget first in the next frame */
+	int32 NextTimeSlicedQuery;
+
+	/** Continues time-sliced queries while budget of frame allows and delivers finished ones */
+	void ProcessTimeSlicedQueries();
+
+	/** Requests of RequestPath made since the last Tick */
+	TArray<FSpiderNavPathRequest> PathRequests;
+
+	/** Number of requests of RequestPath since the grid has been loaded */
+	int32 PathRequestsNum;
+
+	/** Number of requests which have taken result of another request with the same nodes */
+	int32 MergedPathRequestsNum;
+
+	/** Searches one path for each distinct pair of nodes of queued requests and delivers it to all of them */
+	void ProcessPathRequests();
+
+	/** Returns flow field to goal node. Builds it if there is no such field in cache */
+	FSpiderNavFlowFieldPtr GetFlowField(const FSpiderNavGraph& NavGraph, int32 GoalIndex);
+
+	/** Returns next node from start to end node by flow field or INDEX_NONE if start node is not covered by the field */
+	int32 FindNextNodeByFlowField(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex);
+
+	/** Id of the last asynchronous query */
+	int32 LastQueryId;
+
+	/** Asynchronous, time-sliced and queued queries which results have not been delivered yet */
+	TSet<int32> PendingQueries;
+
+	/** Pending queries which results should not be delivered */
+	TSet<int32> CancelledQueries;
 
-	void ResetGridMetrics();
-	TArray<FVector> BuildPathFromEndNode(FSpiderNavNode* EndNode);
+	/** Returns id of new query and marks it as pending */
+	int32 StartQuery();
 
-    FSpiderNavNode* FindClosestNode(FVector Location);
+	/** Forgets query which result is ready. Returns false if it has been cancelled, so its result should not be delivered */
+	bool FinishQuery(int32 QueryId);
+
+	/** Returns bGridReady. Queries to grid which is not ready return at once without searching */
+	bool CheckGridReady(const TCHAR* QueryName) const;
+
+	/** Number of asynchronous queries running on worker threads */
+	FThreadSafeCounter PendingQueriesNum;
+
+	/** Nodes of path of the last FindPathInto. Kept between calls to reuse its memory */
+	TArray<int32> NodesPathBuffer;
+
+	/** Returns index of the closest node or INDEX_NONE if grid is empty */
+	int32 FindClosestNode(const FSpiderNavGraph& NavGraph, FVector Location) const;
+
+	/** Finds the closest node for each location in one batch */
+	void FindClosestNodes(const FSpiderNavGraph& NavGraph, const TArray<FVector>& Locations, TArray<int32>& OutIndexes) const;
+
+	/** Finds the closest node starting from node of handle and stores it in handle */
+	int32 FindClosestNode(const FSpiderNavGraph& NavGraph, FVector Location, FSpiderNavLocationHandle& Handle) const;
 
-	void AddGridNode(int32 SavedIndex, FVector Location, FVector Normal);
-	void SetGridNodeNeighbors(int32 SavedIndex, TArray<int32> NeighborsSavedIndexes);
 	void EmptyGrid();
 
-	TArray<FSpiderNavNode*> FindNodesPath(FSpiderNavNode* StartNode, FSpiderNavNode* EndNode, bool& bFoundCompletePath);
-	TArray<FSpiderNavNode*> BuildNodesPathFromEndNode(FSpiderNavNode* EndNode);
+	/** Reads grid saved by old builders which use save game. Returns false if there is no such save */
+	bool LoadGridDataFromSaveGame(FSpiderNavGridData& OutGridData) const;
+
+	/** Loads GridAsset on the game thread and copies grid from it. Used by synchronous loading only. Returns false if asset is not set, can not be loaded or has no grid */
+	bool LoadGridDataFromAsset(FSpiderNavGridData& OutGridData);
+
+	/** Returns current settings of building grid */
+	FSpiderNavBuildSettings GetBuildSettings() const;
+
+	/** Builds runtime grid with clusters, contraction hierarchy and landmarks from loaded data */
+	static FSpiderNavGraphPtr BuildGraph(FSpiderNavGridData&& GridData, const FSpiderNavBuildSettings& Settings);
+
+	/** Stitches runtime grid from some of Tiles. Tiles which are also in PreviousGraph are copied from it keeping indexes of their nodes */
+	static FSpiderNavGraphPtr BuildStreamedGraph(FSpiderNavTilesPtr Tiles, const TArray<int32>& TileIndexes, FSpiderNavGraphPtr PreviousGraph, const FSpiderNavBuildSettings& Settings);
+
+	/** Splits loaded grid into tiles of StreamingTileSize */
+	static FSpiderNavTilesPtr BuildTiles(FSpiderNavGridData&& GridData, const FSpiderNavBuildSettings& Settings);
+
+	/** Replaces grid used by new queries and forgets everything computed for the old one */
+	void SetGraph(FSpiderNavGraphPtr NewGraph);
+
+	/**
+	 * Replaces streamed grid by grid stitched from it. Cached paths, searches of agents and flow fields over kept nodes are moved to the new grid,
+	 * others are dropped. Statistics and scratch memory are kept
+	 */
+	void SwapStreamedGraph(FSpiderNavGraphPtr NewGraph);
+
+	/** Whether the last loading of grid has been finished */
+	bool bGridReady;
+
+	/** Id of the last loading of grid. Results of older asynchronous loadings are dropped */
+	int32 GridLoadId;
+
+	/** Loads packages of grid assets in background */
+	FStreamableManager StreamableManager;
+
+	/** Keeps GridAsset loaded while its loading is in progress */
+	TSharedPtr<FStreamableHandle> GridAssetHandle;
+
+	/**
+	 * Builds grid on a worker thread. Takes GridData if it is passed, copies grid of Asset there if it is passed, otherwise reads binary file there.
+	 * AssetHandle keeps Asset loaded until the worker has copied its grid, it is released on the game thread
+	 */
+	void BuildGraphAsync(int32 LoadId, TSharedPtr<FSpiderNavGridData, ESPMode::ThreadSafe> GridData, const USpiderNavGridAsset* Asset = nullptr, TSharedPtr<FStreamableHandle> AssetHandle = nullptr);
+
+	/** Builds grid of loaded GridAsset on a worker thread. Falls back to binary file if asset has no grid */
+	void OnGridAssetLoaded(int32 LoadId);
+
+	/** Swaps built grid or tiles in on the game thread. Falls back to save game if grid has been neither passed from game thread nor read from binary file */
+	void FinishGridLoading(int32 LoadId, FSpiderNavGraphPtr NewGraph, FSpiderNavTilesPtr NewTiles, bool bFromGameThread);
+
+	/** The whole grid split into tiles when bStreamTiles. Null if grid is not streamed */
+	FSpiderNavTilesPtr StreamingTiles;
+
+	/** Sorted indexes of tiles which current grid has been built from */
+	TArray<int32> StreamedTiles;
+
+	/** Actors added by AddStreamingSource. Pawns of players are not kept here */
+	TArray<TWeakObjectPtr<AActor>> StreamingSources;
+
+	/** Time of the last query which has ended in each tile or zero. Sized once for all tiles, so queries do not allocate. Filled by worker threads too */
+	TArray<double> RequestedTiles;
+
+	FCriticalSection RequestedTilesLock;
+
+	/** Whether grid of new set of tiles is being built on a worker thread */
+	bool bStreamingInProgress;
+
+	float TimeToStreamingUpdate;
 
-	TArray<FSpiderNavNode*> OpenList;
-	FSpiderNavNode* GetFromOpenList();
+	/** Memory of runtime grid per streamed node measured on the last streamed grid */
+	float StreamingBytesPerNode;
+
+	/** Replaces tiles which are streamed. Null stops streaming */
+	void SetStreamingTiles(FSpiderNavTilesPtr Tiles);
+
+	/** Builds grid of tiles around streaming sources if they have changed. Grid is built on a worker thread unless bSynchronous */
+	void UpdateStreaming(bool bSynchronous);
+
+	/** Chooses tiles closer than StreamingRadius to streaming sources and requested tiles, the closest ones first, while they fit into StreamingMemoryBudget */
+	void ChooseStreamedTiles(TArray<int32>& OutTiles);
+
+	/** Swaps grid of new set of tiles in. The first grid after loading makes grid ready */
+	void FinishStreaming(int32 LoadId, FSpiderNavGraphPtr NewGraph, const TArray<int32>& Tiles);
+
+	/** Whether tile of location is in grid or has no nodes at all. Tile is requested, so it is streamed in or kept for StreamingRequestTimeout. Safe to call from worker threads */
+	bool IsLocationStreamedIn(const FSpiderNavGraph& NavGraph, const FVector& Location);
+
+	/** Finds path between closest nodes to locations. Safe to call from worker threads */
+	TArray<FVector> FindLocationsPath(const FSpiderNavGraph& NavGraph, FVector Start, FVector End, bool& bFoundCompletePath);
+
+	/** Fills OutPath and OutNodesPath keeping their memory. Safe to call from worker threads if buffers are not shared */
+	void FindLocationsPath(const FSpiderNavGraph& NavGraph, FVector Start, FVector End, TArray<FVector>& OutPath, TArray<int32>& OutNodesPath, bool& bFoundCompletePath);
+
+	/** Finds path between closest nodes to locations and returns index of the second node of path. Safe to call from worker threads */
+	bool FindNextNode(const FSpiderNavGraph& NavGraph, FVector CurrentLocation, FVector TargetLocation, int32& NextIndex);
+
+	/** Takes path from cache or searches it with SearchNodesPath */
+	void FindNodesPath(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath);
+
+	/** Searches path by algorithm of SearchMode */
+	void SearchNodesPath(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath);
+
+	/** A-star. If AllowedClusters is passed, search does not leave these clusters. Landmarks are used if HeuristicMode asks for them and bAllowLandmarks */
+	void FindNodesPath(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath, const TBitArray<>* AllowedClusters = nullptr, bool bAllowLandmarks = true);
+
+	/** Starts A-star which is continued by StepNodesPath. Start and end nodes must be valid. Unreachable end is replaced by the closest reachable node to it */
+	void BeginNodesPath(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, FSpiderNavAStarState& State, int32 StartIndex, int32 EndIndex, const TBitArray<>* AllowedClusters = nullptr, bool bAllowLandmarks = true);
+
+	/** Expands up to MaxExpandedNodesNum nodes. Returns true if search is finished */
+	bool StepNodesPath(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, FSpiderNavAStarState& State, int32 MaxExpandedNodesNum);
+
+	/** Returns complete path or partial path to the closest node if end has not been reached */
+	void FinishNodesPath(const FSpiderNavSearchContext& Context, const FSpiderNavAStarState& State, TArray<int32>& OutPath, bool& bFoundCompletePath);
+
+	/** Searches abstract graph of clusters first, then refines path inside clusters which abstract path goes through */
+	void FindNodesPathHierarchical(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath);
+
+	/** Searches contraction hierarchy and unpacks shortcuts of found path. Falls back to A-star for partial path if end is not reachable */
+	void FindNodesPathContractionHierarchy(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath);
+
+	/** Bidirectional A-star. Falls back to A-star for partial path if end is not reachable */
+	void FindNodesPathBidirectional(const FSpiderNavGraph& NavGraph, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath, bool& bFoundCompletePath);
+
+	/** Bidirectional A-star with average potentials of both directions. Returns false and empty path if end is not reachable */
+	bool FindNodesPathBidirectional(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& ForwardContext, FSpiderNavSearchContext& BackwardContext, int32 StartIndex, int32 EndIndex, TArray<int32>& OutPath);
+
+	/** Lower bound of cost of path between nodes by HeuristicMode */
+	float EstimateCost(const FSpiderNavGraph& NavGraph, int32 FromIndex, int32 ToIndex) const;
+
+	/** Finds costs of paths from node to entrances of its cluster which do not leave the cluster */
+	void SearchClusterEntrances(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 NodeIndex, TArray<TPair<int32, float>>& OutEntrancesCosts);
+
+	/** A-star over abstract graph between entrances of start and end clusters. Returns abstract nodes of path */
+	bool SearchAbstractPath(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 StartIndex, int32 EndIndex, const TArray<TPair<int32, float>>& StartEntrances, const TArray<TPair<int32, float>>& EndEntrances, TArray<int32>& OutAbstractPath);
+	void BuildNodesPathFromEndNode(const FSpiderNavSearchContext& Context, int32 EndIndex, TArray<int32>& OutPath);
+
+	/** Finds paths for many pairs of nodes. Pairs with the same end node share one search. Groups of pairs are processed in parallel */
+	void FindNodesPaths(const FSpiderNavGraph& NavGraph, const TArray<int32>& StartIndexes, const TArray<int32>& EndIndexes, TArray<TArray<int32>>& OutPaths, TArray<bool>& OutFoundCompletePaths);
+
+	/**
+	 * Searches from end node until all start nodes are closed. Relies on symmetric edges which are written by SpiderNavGridBuilder.
+	 * Parents of closed nodes point towards end node. Returns false if some of start nodes are unreachable
+	 */
+	bool SearchFromEndNode(const FSpiderNavGraph& NavGraph, FSpiderNavSearchContext& Context, int32 EndIndex, const TArray<int32>& StartIndexes);
+
+	/** Builds path from start node to end node of search made by SearchFromEndNode */
+	TArray<int32> BuildNodesPathToEndNode(const FSpiderNavSearchContext& Context, int32 StartIndex);
 
 public:	
 
@@ -158,6 +514,90 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
 	bool bAutoLoadGrid;
 
+	/** Whether the grid of bAutoLoadGrid is built on a worker thread. Queries report that the grid is not ready until OnGridReady, see IsGridReady */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	bool bLoadGridAsync;
+
+	/** Grid of this map written by builder. It is cooked with the map. Binary file in Saved directory and save game are read if it is not set */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	TSoftObjectPtr<USpiderNavGridAsset> GridAsset;
+
+	/** Called when loading of grid is finished. Streamed grid is finished when tiles around players are streamed in the first time */
+	UPROPERTY(BlueprintAssignable, Category = "SpiderNavigation")
+	FSpiderNavGridReadyDelegate OnGridReady;
+
+	/** Maximum number of paths between nodes kept in cache. Zero disables cache */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	int32 PathCacheSize;
+
+	/** Whether only tiles around players and streaming sources are kept in runtime grid. Paths to other tiles are partial. Hierarchical and contraction hierarchy searches fall back to A-star */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	bool bStreamTiles;
+
+	/** Length of edge of cubic tile of streaming */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float StreamingTileSize;
+
+	/** Tiles closer than this to players and streaming sources are streamed in */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float StreamingRadius;
+
+	/** Maximum memory of tiles of the whole grid and runtime grid of streamed tiles in megabytes. The closest tiles are kept when not all of them fit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float StreamingMemoryBudgetMB;
+
+	/** How often streamed tiles are checked in seconds */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float StreamingUpdateInterval;
+
+	/** How long tile where path query has ended is kept streamed in, in seconds */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float StreamingRequestTimeout;
+
+	/** Algorithm used to find path between nodes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	ESpiderNavSearchMode SearchMode;
+
+	/** Lower bound of path cost used by A-star */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	ESpiderNavHeuristic HeuristicMode;
+
+	/** Number of landmarks computed on load for Landmarks heuristic. Each one takes 2 bytes per node */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	int32 LandmarksNum;
+
+	/** How locations and normals of nodes are kept in memory after loading */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	ESpiderNavStorageMode StorageMode;
+
+	/** Precision of locations of Quantized storage mode. One tile covers 65535 of steps along each axis */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float QuantizationStep;
+
+	/** Maximum number of nodes expanded by all time-sliced queries in one frame. Zero means no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	int32 TimeSlicedMaxExpandedNodes;
+
+	/** Maximum time spent on time-sliced queries in one frame in microseconds. Zero means no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float TimeSlicedMaxMicroseconds;
+
+	/** Whether FindNextLocationAndNormal uses one flow field per target node shared by all agents instead of search per agent */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	bool bUseFlowFields;
+
+	/** Maximum cost of path covered by flow field. Agents which are farther use usual search. Zero means no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float FlowFieldMaxCost;
+
+	/** Maximum number of target nodes which flow fields are kept */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	int32 FlowFieldsCacheSize;
+
+	/** Maximum number of nodes kept by search of one agent of FindNextLocationAndNormalForAgent. Agents which need more use usual search. Zero means no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	int32 AgentPlannerMaxNodesNum;
+
     /** Thickness of debug lines */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavGridBuilder")
 	float DebugLinesThickness;
@@ -166,14 +606,92 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
 	int32 GetNavNodesCount();
 
-	/** Finds path in grid. Returns array of nodes */
+	/** Finds path in grid. Returns array of nodes. Returns empty array if the grid is not ready, see IsGridReady */
 	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
 	TArray<FVector> FindPath(FVector Start, FVector End, bool& bFoundCompletePath);
 
-    /** Loads navigation grid from file */
+	/**
+	 * Finds path in grid and writes it to caller-owned OutPath. Memory of OutPath and of search buffers is reused,
+	 * so a repeated query does not allocate once buffers have grown. Game thread only. Returns false if path is empty or the grid is not ready
+	 */
+	bool FindPathInto(FVector Start, FVector End, TArray<FVector>& OutPath, bool& bFoundCompletePath);
+
+	/**
+	 * Moves handle to the closest node to location. Only neighbors of the previous node are checked while location moves smoothly.
+	 * Returns false if grid is empty
+	 */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	bool UpdateLocationHandle(UPARAM(ref) FSpiderNavLocationHandle& Handle, FVector Location, FVector& NodeLocation, FVector& NodeNormal);
+
+	/** Finds path in grid on a worker thread. Returns id of query which is passed to OnPathFound on the game thread. Returns 0 and does not call OnPathFound if the grid is not ready */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	int32 FindPathAsync(FVector Start, FVector End, const FSpiderNavPathQueryDelegate& OnPathFound);
+
+	/**
+	 * Finds path with A-star spread over frames. Each frame all time-sliced queries together expand no more than TimeSlicedMaxExpandedNodes
+	 * nodes and run no longer than TimeSlicedMaxMicroseconds. Returns id of query which is passed to OnPathFound on the game thread.
+	 * Returns 0 and does not call OnPathFound if the grid is not ready
+	 */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	int32 FindPathTimeSliced(FVector Start, FVector End, const FSpiderNavPathQueryDelegate& OnPathFound);
+
+	/** Whether path exists between the closest nodes to locations. Does not search */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	bool IsReachable(FVector Start, FVector End);
+
+	/**
+	 * Queues path query which is processed in the next Tick. Requests made in the same frame with the same closest nodes
+	 * share one search. Returns id of query which is passed to OnPathFound on the game thread. Returns 0 and does not call OnPathFound if the grid is not ready
+	 */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	int32 RequestPath(FVector Start, FVector End, const FSpiderNavPathQueryDelegate& OnPathFound);
+
+	/** Cancels asynchronous, time-sliced or queued query. Its delegate will not be called. Does nothing if result has been delivered already */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void CancelAsyncQuery(int32 QueryId);
+
+    /** Returns statistics of path cache since the grid has been loaded */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void GetPathCacheStats(int32& Hits, int32& Misses, int32& CachedPaths);
+
+    /** Returns number of requests of RequestPath and number of them merged with another request since the grid has been loaded */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void GetPathRequestStats(int32& Requests, int32& MergedRequests);
+
+    /** Returns memory used by the loaded grid with all its indexes, spatial index included, and its part per node */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void GetGridMemoryStats(int32& TotalBytes, float& BytesPerNode);
+
+    /** Runs QueriesNum path queries between random nodes and logs search statistics of A-star, A-star with landmarks and bidirectional A-star if they are used. Returns expanded nodes per second of SearchMode */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	float BenchmarkFindPath(int32 QueriesNum = 1000);
+
+    /** Loads navigation grid from binary file written by the builder. Falls back to save game of old builders */
 	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
     bool LoadGrid();
 
+	/** Loads and builds navigation grid on a worker thread. Queries report that the grid is not ready until OnGridReady is called */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void LoadGridAsync();
+
+	/**
+	 * Whether loading of grid has been finished. Before that queries return at once: asynchronous ones return query id 0 and never call
+	 * their delegates, batched ones return empty arrays, and the others return false or empty path. It tells such results from unreachable targets
+	 */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	bool IsGridReady() const;
+
+	/** Keeps tiles around actor streamed in. Pawns of players are streaming sources without it */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void AddStreamingSource(AActor* Source);
+
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void RemoveStreamingSource(AActor* Source);
+
+	/** Returns number of tiles in grid and number of all tiles. Both are zero if grid is not streamed */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void GetStreamingStats(int32& StreamedTilesNum, int32& TilesNum);
+
     /** Draws debug lines between connected nodes */
 	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
 	void DrawDebugRelations();
@@ -182,11 +700,35 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
 	FVector FindClosestNodeLocation(FVector Location);
 
+    /** Finds locations of up to Count closest nodes in grid to specified location. Locations are sorted by distance */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	TArray<FVector> FindClosestNodesLocations(FVector Location, int32 Count);
+
     /** Finds closest node's normal in grid to specified location  */
 	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
 	FVector FindClosestNodeNormal(FVector Location);
 
-    /** Finds path between current location and target location and returns location and normal of the next fisrt node in navigation grid */
+    /** Finds path between current location and target location and returns location and normal of the next fisrt node in navigation grid. Returns false if the grid is not ready */
 	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
 	bool FindNextLocationAndNormal(FVector CurrentLocation, FVector TargetLocation, FVector& NextLocation, FVector& Normal);
+
+    /** Finds paths for many agents at once. Starts and Ends must have the same length. Returns empty array if the grid is not ready */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	TArray<FSpiderNavPath> FindPaths(const TArray<FVector>& Starts, const TArray<FVector>& Ends);
+
+    /** Does the same as FindNextLocationAndNormal for many agents at once. CurrentLocations and TargetLocations must have the same length. Outputs are empty if the grid is not ready */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void FindNextLocationsAndNormals(const TArray<FVector>& CurrentLocations, const TArray<FVector>& TargetLocations, TArray<bool>& Found, TArray<FVector>& NextLocations, TArray<FVector>& Normals);
+
+    /** Does the same as FindNextLocationAndNormal, but keeps search of Agent between calls and continues it when the agent or the target moves instead of searching from scratch */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	bool FindNextLocationAndNormalForAgent(AActor* Agent, FVector CurrentLocation, FVector TargetLocation, FVector& NextLocation, FVector& Normal);
+
+    /** Frees search kept for Agent by FindNextLocationAndNormalForAgent */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void ForgetAgent(AActor* Agent);
+
+    /** Does the same as FindNextLocationAndNormal on a worker thread. Returns id of query which is passed to OnNextLocationFound on the game thread. Returns 0 and does not call OnNextLocationFound if the grid is not ready */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	int32 FindNextLocationAndNormalAsync(FVector CurrentLocation, FVector TargetLocation, const FSpiderNavNextLocationQueryDelegate& OnNextLocationFound);
 };
@@ -0,0 +1,136 @@
+//The MIT License
+//
+//Copyright(C) 2017 Roman Nix
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in
+//all copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//THE SOFTWARE.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavigation.h"
+#include "SpiderPathFollowingComponent.generated.h"
+
+/**
+ * Moves owner along a path which is found once and cached.
+ * Path is found again only if the closest node of target changes, owner leaves corridor of path or grid is reloaded.
+ * Path through tiles which stay streamed in is kept when streamed grid changes
+ */
+UCLASS(ClassGroup = (SpiderNavigation), meta = (BlueprintSpawnableComponent))
+class USpiderPathFollowingComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	USpiderPathFollowingComponent();
+
+	/** Navigation which finds paths. The first SpiderNavigation of level is used if it is not set */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	ASpiderNavigation* Navigation;
+
+	/** Owner has reached point of path if it is closer than this */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float AcceptanceRadius;
+
+	/** Path is found again if owner is farther than this from the current segment of path */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SpiderNavigation")
+	float CorridorRadius;
+
+	/** Number of times path has been found */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "SpiderNavigation")
+	int32 ReplansNum;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Follows actor. Its location is checked every tick */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void SetTargetActor(AActor* InTargetActor);
+
+	/** Follows fixed location */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void SetTargetLocation(FVector InTargetLocation);
+
+	/** Stops following and forgets path */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	void ClearTarget();
+
+	/** Returns location and normal of the next point of path. Returns false if there is no path */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	bool GetNextLocationAndNormal(FVector& NextLocation, FVector& Normal) const;
+
+	/** Whether owner has reached the last point of path */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	bool HasReachedPathEnd() const;
+
+	/** Returns locations of the rest of path starting from the next point */
+	UFUNCTION(BlueprintCallable, Category = "SpiderNavigation")
+	TArray<FVector> GetRemainingPath() const;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Checks whether path is still valid for owner and target, finds new one if not, then advances to the next point */
+	void UpdatePath();
+
+	/** Finds path from owner location to the closest node of target. Returns false if no path is found */
+	bool Replan(const FVector& OwnerLocation, const FVector& InTargetLocation);
+
+	/**
+	 * Moves complete path to grid stitched from grid of path if the rest of path is kept there and target has the same closest node.
+	 * Returns false if path has to be found again
+	 */
+	bool AdoptGraph(const FSpiderNavGraphPtr& NewGraph, const FVector& InTargetLocation);
+
+	bool GetTargetLocation(FVector& OutLocation) const;
+
+	TWeakObjectPtr<AActor> TargetActor;
+
+	FVector TargetLocation;
+
+	bool bHasTarget;
+
+	/** Whether target is TargetActor or TargetLocation */
+	bool bFollowsActor;
+
+	/** Grid of cached path. Path is found again when navigation loads another grid */
+	FSpiderNavGraphPtr PathGraph;
+
+	/** Nodes of cached path. Memory is kept between replans */
+	TArray<int32> NodesPath;
+
+	/** Whether cached path reaches TargetNodeIndex */
+	bool bFoundCompletePath;
+
+	/** Index of the next point of NodesPath which owner moves to */
+	int32 NextPointIndex;
+
+	/** Closest node to target when path was found */
+	int32 TargetNodeIndex;
+
+	/** Target location when its closest node was checked. The node is not looked up while target stays still */
+	FVector CheckedTargetLocation;
+
+	/** Closest nodes of owner and target. They are updated by checking neighbors of the previous nodes */
+	FSpiderNavLocationHandle OwnerHandle;
+
+	FSpiderNavLocationHandle TargetHandle;
+};